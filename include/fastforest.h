@@ -32,6 +32,8 @@ SOFTWARE.
 #endif
 
 #include <istream>
+#include <map>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -50,10 +52,33 @@ namespace fastforest {
     namespace details {
 
         void softmaxTransformInplace(TreeEnsembleResponseType* out, int nOut);
+        void softmaxTransformInplace(double* out, int nOut);
 
     }
 
+    // Statistics about the evaluation of a FastForest, accumulated over all rows passed to FastForest::profile.
+    // Such a profile can be used to understand where the inference time goes, or to optimize the node layout.
+    struct ForestProfile {
+        ForestProfile() : nRows(0) {}
+
+        // Writes a human-readable summary of the statistics
+        void write_report(std::ostream& os) const;
+
+        std::size_t nRows;
+        // how often each node was visited, and how often the left child was taken from there
+        std::vector<std::size_t> nodeVisits;
+        std::vector<std::size_t> leftTaken;
+        // how often each leaf was reached
+        std::vector<std::size_t> leafHits;
+        // total number of nodes visited in each tree, which is the sum of the path lengths
+        std::vector<std::size_t> treeNodeVisits;
+        // how often each feature was read
+        std::vector<std::size_t> featureAccesses;
+    };
+
     struct FastForest {
+        FastForest() : maxLeavesPerTree_(0) {}
+
         inline TreeEnsembleResponseType operator()(const FeatureType* array) const { return evaluateBinary(array); }
 
 #if __cplusplus >= 201103L
@@ -73,11 +98,77 @@ namespace fastforest {
 
         // softmax interface that is not a pure function, but no manual allocation and no compile-time knowledge needed
         void softmax(const FeatureType* array, TreeEnsembleResponseType* out) const;
+        // same with the scores accumulated in double precision, see predict
+        void softmax(const FeatureType* array, double* out) const;
+
+        // Evaluates nRows rows, with row i read from `array + i * rowStride`. The raw scores are written to
+        // `out + i * nOutputs()`, without softmax transformation for multiclassification. The rows are evaluated in
+        // blocks tree by tree, such that the nodes of each tree are reused from the cache for all rows in a block,
+        // and they are distributed over nThreads threads if the library was compiled with C++11.
+        void predict(const FeatureType* array,
+                     int nRows,
+                     int rowStride,
+                     TreeEnsembleResponseType* out,
+                     int nThreads = 1) const;
+        // Same as above, but the tree responses are summed up in double precision. This avoids the rounding errors
+        // that build up when adding many small leaf values in float precision, which can matter for large forests.
+        // The thresholds and leaf values are still stored as floats, so the model and its binary format are the same.
+        void predict(const FeatureType* array, int nRows, int rowStride, double* out, int nThreads = 1) const;
+
+        // Writes the index of the leaf that each of the nRows rows ends up in for every tree, like `pred_leaf=True` in
+        // XGBoost. Row i is read from `array + i * rowStride` and its leaf indices are written to `out + i * nTrees()`.
+        // The leaf indices are counted within each tree, starting from zero. Note that trees consisting of only a
+        // single leaf are absorbed in the base responses when loading the model, so they don't appear in the output.
+        // The rows are evaluated in blocks and threads like in predict.
+        void predictLeaves(const FeatureType* array, int nRows, int rowStride, int* out, int nThreads = 1) const;
+        void predictLeaves(
+            const FeatureType* array, int nRows, int rowStride, unsigned short* out, int nThreads = 1) const;
+        // Finds the first leaf of each tree, which predictLeaves needs to count the leaves within each tree. The
+        // loading functions already do this, but it has to be done again after changing the arrays by hand, and it
+        // saves predictLeaves walking all nodes in each call for forests that were built otherwise.
+        void prepareLeafIndices();
+
+        // Computes the SHAP feature contributions with the path-dependent TreeSHAP algorithm, like
+        // `pred_contribs=True` in XGBoost. Row i is read from `array + i * rowStride`, and for each class
+        // `nFeatures + 1` contributions are written to `out + i * nOut * (nFeatures + 1)`, where nOut is one for
+        // binary classification and the number of classes otherwise. The last contribution of each class is the bias.
+        // This requires the cover statistics of the nodes, which are only available if the model was dumped with
+        // `with_stats=True`. The rows are distributed over nThreads threads if the library was compiled with C++11.
+        void predictContributions(const FeatureType* array,
+                                  int nRows,
+                                  int rowStride,
+                                  int nFeatures,
+                                  TreeEnsembleResponseType* out,
+                                  int nThreads = 1) const;
+
+        // Evaluates nRows rows with an instrumented version of the tree traversal, accumulating statistics about
+        // the visited nodes into the profile. The regular evaluation functions are not affected by this.
+        void profile(const FeatureType* array, int nRows, int rowStride, ForestProfile& profile) const;
 
         void write_bin(std::string const& filename) const;
+        // Writes the forest in a compressed binary format, which is usually several times smaller than the one of
+        // write_bin. The index arrays are delta encoded and bit-packed and the bytes of the float arrays are grouped,
+        // before all arrays are compressed with a built-in LZ77 codec. Read it back with
+        // fastforest::load_compressed_bin.
+        void write_compressed_bin(std::string const& filename) const;
+
+        // Appends the trees of another forest with the same features and classes, for example from further boosting
+        // rounds. The base responses of this forest are kept, because they already contain the base score. Trees of
+        // the other forest with a single leaf were absorbed in its base responses, so they are not appended. Use the
+        // delta files written by fastforest::write_delta_bin to apply updates exactly.
+        void append(FastForest const& other);
+        // Appends the new trees of an update written by fastforest::write_delta_bin and replaces the base responses,
+        // throwing if the update was made for a different forest. Afterwards, the forest equals the updated one.
+        void append_delta_bin(std::string const& filename);
+        void append_delta_bin(std::istream& is);
 
         int nClasses() const { return baseResponses_.size() > 2 ? baseResponses_.size() : 2; }
 
+        int nTrees() const { return rootIndices_.size(); }
+
+        // Number of raw scores per row: one for binary classification, and the number of classes otherwise
+        int nOutputs() const { return baseResponses_.size(); }
+
         std::vector<int> rootIndices_;
         std::vector<CutIndexType> cutIndices_;
         std::vector<FeatureType> cutValues_;
@@ -86,19 +177,535 @@ namespace fastforest {
         std::vector<TreeResponseType> responses_;
         std::vector<int> treeNumbers_;
         std::vector<TreeEnsembleResponseType> baseResponses_;
+        // Optional cover statistics (sum of hessians) for each node and leaf, needed for the feature contributions
+        std::vector<TreeResponseType> nodeCovers_;
+        std::vector<TreeResponseType> leafCovers_;
 
       private:
         void evaluate(const FeatureType* array, TreeEnsembleResponseType* out, int nOut) const;
 
+        template <class LeafIndex_t>
+        void predictLeavesImpl(
+            const FeatureType* array, int nRows, int rowStride, LeafIndex_t* out, int nThreads) const;
+
         TreeEnsembleResponseType evaluateBinary(const FeatureType* array) const;
+
+        // set by prepareLeafIndices
+        std::vector<int> firstLeaves_;
+        int maxLeavesPerTree_;
+    };
+
+    // A read-only forest with all arrays stored in one contiguous memory block, aligned to cache lines or to huge
+    // pages for large models. The block has exactly the layout of the files written by FastForest::write_bin, so
+    // copying a forest is a single memcpy and the block can be written to or read from a file as it is. The memory is
+    // first written by the thread that constructs the forest, so on NUMA systems it is placed on that thread's node.
+    class ArenaForest {
+      public:
+        ArenaForest();
+        explicit ArenaForest(FastForest const& ff);
+        ArenaForest(ArenaForest const& other);
+        ArenaForest& operator=(ArenaForest const& other);
+#if __cplusplus >= 201103L
+        ArenaForest(ArenaForest&& other) : ArenaForest() { swap(other); }
+        ArenaForest& operator=(ArenaForest&& other) {
+            swap(other);
+            return *this;
+        }
+#endif
+        ~ArenaForest();
+
+        void swap(ArenaForest& other);
+
+        TreeEnsembleResponseType operator()(const FeatureType* array) const;
+        std::vector<TreeEnsembleResponseType> softmax(const FeatureType* array) const;
+        void softmax(const FeatureType* array, TreeEnsembleResponseType* out) const;
+        // raw scores of all classes without softmax transformation, or the single score for binary classification
+        void evaluate(const FeatureType* array, TreeEnsembleResponseType* out) const;
+
+        int nClasses() const { return nBaseResponses_ > 2 ? nBaseResponses_ : 2; }
+        int nTrees() const { return nRootNodes_; }
+
+        FastForest toFastForest() const;
+
+        // the memory block with the same content as a file written by FastForest::write_bin
+        const char* data() const { return data_; }
+        std::size_t size() const { return size_; }
+        // whether the memory block is an external buffer that was not copied, see load_arena_bin
+        bool isView() const { return memory_ == NULL && size_ > 0; }
+        void write_bin(std::string const& filename) const;
+
+      private:
+        friend ArenaForest load_arena_bin(std::string const& filename);
+        friend ArenaForest load_arena_bin(const void* data, std::size_t size, bool copy);
+
+        void allocate(std::size_t size);
+        void setPointers();
+
+        char* memory_;
+        char* data_;
+        std::size_t size_;
+
+        int nRootNodes_;
+        int nNodes_;
+        int nLeaves_;
+        int nBaseResponses_;
+        const int* rootIndices_;
+        const CutIndexType* cutIndices_;
+        const FeatureType* cutValues_;
+        const int* leftIndices_;
+        const int* rightIndices_;
+        const TreeResponseType* responses_;
+        const int* treeNumbers_;
+        const TreeEnsembleResponseType* baseResponses_;
     };
 
-    FastForest load_txt(std::string const& txtpath, std::vector<std::string>& features, int nClasses = 2);
+    // Reads a file written by FastForest::write_bin directly into the memory block of an ArenaForest
+    ArenaForest load_arena_bin(std::string const& filename);
+
+    // Creates an ArenaForest from the content of a binary file that is already in memory. If copy is false and the
+    // buffer is aligned for the int and float arrays, the forest refers to the buffer directly instead of copying it,
+    // so the buffer has to outlive the forest and all its moved-to instances. Copies of the forest own their memory.
+    ArenaForest load_arena_bin(const void* data, std::size_t size, bool copy = true);
+
+    // Evaluates a forest with many threads on multi-socket machines. The forest is replicated once per NUMA node,
+    // with each replica being created by a thread bound to the CPUs of that node, such that its memory is local to
+    // the node. The worker threads are distributed over the nodes, bound to their CPUs, and only read their local
+    // replica. The NUMA topology is read from sysfs on Linux. On other systems, or if the library was not compiled
+    // with C++11, there is only one replica and the threads are not bound.
+    class NumaForest {
+      public:
+        explicit NumaForest(FastForest const& ff);
+
+        int nReplicas() const { return replicas_.size(); }
+        // Number of outputs per row: one for binary classification, and the number of classes otherwise
+        int nOutputs() const { return nOutputs_; }
+
+        // Evaluates nRows rows, with row i read from `array + i * rowStride`, using nThreads threads. The raw
+        // scores are written to `out + i * nOutputs()`, without softmax transformation.
+        void evaluate(const FeatureType* array,
+                      int nRows,
+                      int rowStride,
+                      TreeEnsembleResponseType* out,
+                      int nThreads) const;
+
+      private:
+        std::vector<ArenaForest> replicas_;
+        // CPUs of each NUMA node, with one entry per replica
+        std::vector<std::vector<int> > nodeCpus_;
+        int nOutputs_;
+    };
+
+    // Evaluates single rows with low latency on very large forests, by splitting the trees over a group of worker
+    // threads. The workers wait for the next row by spinning, so they respond quickly but keep their CPUs busy, and
+    // the partial sums are collected without locks. The calling thread evaluates the first range of trees itself.
+    // Forests with fewer than minTreesPerThread trees per thread are evaluated serially, as well as all forests if
+    // the library was not compiled with C++11. The partial sums are added in a fixed order, so the results are
+    // reproducible, but they can differ from FastForest in the last bits. Calls from several threads are serialized.
+    class LowLatencyForest {
+      public:
+        // If cpus is not empty, worker i is bound to cpus[i % cpus.size()], and the calling thread is not bound
+        LowLatencyForest(FastForest const& ff,
+                         int nThreads,
+                         int minTreesPerThread = 256,
+                         std::vector<int> const& cpus = std::vector<int>());
+        ~LowLatencyForest();
+
+        TreeEnsembleResponseType operator()(const FeatureType* array) const;
+        std::vector<TreeEnsembleResponseType> softmax(const FeatureType* array) const;
+        void softmax(const FeatureType* array, TreeEnsembleResponseType* out) const;
+        // raw scores of all classes without softmax transformation, or the single score for binary classification
+        void evaluate(const FeatureType* array, TreeEnsembleResponseType* out) const;
+
+        // number of threads that take part in each evaluation, including the calling thread
+        int nThreads() const;
+        int nClasses() const { return forest_.nClasses(); }
+
+      private:
+        // not copyable, because of the worker threads
+        LowLatencyForest(LowLatencyForest const&);
+        LowLatencyForest& operator=(LowLatencyForest const&);
+
+        struct Workers;
+
+        FastForest forest_;
+        Workers* workers_;
+    };
+
+    // Storage formats for the leaf values of a QuantizedForest
+    enum LeafPrecision {
+        // IEEE half precision, with 11 significant bits and a range up to 65504
+        LeafFloat16,
+        // the upper half of a float, with 8 significant bits and the full float range
+        LeafBFloat16,
+        // 8-bit integers, scaled by one float for each block of consecutive leaves
+        LeafInt8
+    };
+
+    // A forest with the leaf values stored in reduced precision, to make large models fit into the caches. The nodes
+    // are the same as in the original forest, so only the leaf values are affected. Use fastforest::quantize to also
+    // measure the resulting error of the predictions.
+    class QuantizedForest {
+      public:
+        QuantizedForest(FastForest const& ff, LeafPrecision precision);
+
+        TreeEnsembleResponseType operator()(const FeatureType* array) const;
+        std::vector<TreeEnsembleResponseType> softmax(const FeatureType* array) const;
+        void softmax(const FeatureType* array, TreeEnsembleResponseType* out) const;
+        // raw scores of all classes without softmax transformation, or the single score for binary classification
+        void evaluate(const FeatureType* array, TreeEnsembleResponseType* out) const;
+        // Evaluates nRows rows, with row i read from `array + i * rowStride` and its raw scores written to
+        // `out + i * nOutputs()`
+        void predict(const FeatureType* array, int nRows, int rowStride, TreeEnsembleResponseType* out) const;
+
+        LeafPrecision precision() const { return precision_; }
+        int nClasses() const { return nodes_.nClasses(); }
+        int nTrees() const { return nodes_.nTrees(); }
+        int nOutputs() const { return nodes_.nOutputs(); }
+        // the value of a leaf after quantization
+        TreeResponseType leafValue(int leaf) const;
+        // memory used by the nodes and leaves in bytes
+        std::size_t size() const;
+
+        // Writes the forest with the leaf values in their reduced precision, read it back with
+        // fastforest::load_quantized_bin
+        void write_bin(std::string const& filename) const;
+
+      private:
+        friend QuantizedForest load_quantized_bin(std::string const& filename);
+
+        QuantizedForest() : precision_(LeafFloat16) {}
+
+        template <class Decoder_t>
+        void evaluate(Decoder_t const& decoder, const FeatureType* array, TreeEnsembleResponseType* out) const;
+
+        LeafPrecision precision_;
+        // the original forest without leaf values and cover statistics
+        FastForest nodes_;
+        std::vector<unsigned short> halfLeaves_;
+        std::vector<signed char> int8Leaves_;
+        std::vector<float> int8Scales_;
+    };
+
+    // Re-scores a row after a few of its features changed, by evaluating only the trees that split on one of them.
+    // The trees that use each feature are found with an inverted index that is built once at construction. The
+    // caller keeps the leaf value of every tree between the calls, such that the scores can be updated with the
+    // differences of the re-evaluated trees. This pays off for wide models where each feature is used by few trees.
+    class IncrementalForest {
+      public:
+        explicit IncrementalForest(FastForest const& ff);
+
+        // Evaluates all trees for one row. The leaf value of each tree is written to `treeValues`, which has to hold
+        // nTrees() values, and the raw scores to `out`, without softmax transformation.
+        void evaluate(const FeatureType* array, TreeResponseType* treeValues, TreeEnsembleResponseType* out) const;
+        // Updates the tree values and raw scores of a previous call after the nChanged features with the given
+        // indices changed in the row. Since the scores are updated by differences, they can differ from a full
+        // evaluation in the last bits. Returns the number of trees that were evaluated.
+        int update(const FeatureType* array,
+                   const int* changedFeatures,
+                   int nChanged,
+                   TreeResponseType* treeValues,
+                   TreeEnsembleResponseType* out) const;
+
+        // Number of trees that split on a feature, and the first of their indices in increasing order
+        int nTreesUsing(int feature) const;
+        const int* treesUsing(int feature) const;
+
+        int nTrees() const { return forest_.nTrees(); }
+        int nOutputs() const { return forest_.nOutputs(); }
+
+      private:
+        FastForest forest_;
+        // the trees that split on feature i are featureTrees_[featureOffsets_[i]] up to featureOffsets_[i + 1]
+        std::vector<int> featureOffsets_;
+        std::vector<int> featureTrees_;
+    };
+
+    // A forest that only reads the input features it actually uses. The used features are numbered densely, with the
+    // most frequently read ones first, such that the features of a row that the trees read fit into few cache lines.
+    // The rows are still passed in the full layout, and CompactForest::predict gathers the used features of a block
+    // of rows into a dense buffer before evaluating the trees on it.
+    class CompactForest {
+      public:
+        // The features are ordered by how often they were read in the profile, if it is given, otherwise by the
+        // number of nodes that split on them. The profile has to be recorded with the same forest.
+        explicit CompactForest(FastForest const& ff, ForestProfile const* profile = NULL);
+
+        // Evaluates nRows rows in the full layout, with row i read from `array + i * rowStride`, and writes the raw
+        // scores to `out + i * nOutputs()`. The results are identical to FastForest::predict.
+        void predict(const FeatureType* array,
+                     int nRows,
+                     int rowStride,
+                     TreeEnsembleResponseType* out,
+                     int nThreads = 1) const;
+        // Copies the used features of a row in the full layout to the nUsedFeatures() values of a compact row
+        void gather(const FeatureType* array, FeatureType* compact) const;
+
+        // the forest with the cut indices referring to compact rows
+        FastForest const& forest() const { return forest_; }
+        // the position in the full row of each compact feature
+        std::vector<int> const& usedFeatures() const { return usedFeatures_; }
+        int nUsedFeatures() const { return usedFeatures_.size(); }
+        int nOutputs() const { return forest_.nOutputs(); }
+
+      private:
+        FastForest forest_;
+        std::vector<int> usedFeatures_;
+    };
+
+    // A forest compiled to a lookup table, for models with only a few features. The forest is a piecewise constant
+    // function on the grid that is formed by the distinct thresholds of each feature, so its raw scores can be
+    // tabulated for each grid cell. Evaluating a row then takes one binary search per feature and one table lookup,
+    // independent of the number of trees. The scores are identical to the ones of the original forest, also for NaN
+    // features. The table grows with the product of the numbers of thresholds, see fastforest::compile_grid.
+    class GridForest {
+      public:
+        GridForest() : nOutputs_(0) {}
+
+        TreeEnsembleResponseType operator()(const FeatureType* array) const { return table_[cellIndex(array)]; }
+        std::vector<TreeEnsembleResponseType> softmax(const FeatureType* array) const;
+        void softmax(const FeatureType* array, TreeEnsembleResponseType* out) const;
+        // raw scores of all classes without softmax transformation, or the single score for binary classification
+        void evaluate(const FeatureType* array, TreeEnsembleResponseType* out) const;
+        // Evaluates nRows rows, with row i read from `array + i * rowStride` and its raw scores written to
+        // `out + i * nOutputs()`
+        void predict(const FeatureType* array, int nRows, int rowStride, TreeEnsembleResponseType* out) const;
+
+        int nClasses() const { return nOutputs_ > 2 ? nOutputs_ : 2; }
+        int nOutputs() const { return nOutputs_; }
+        // number of grid cells, and the memory used by the table and thresholds in bytes
+        std::size_t nCells() const { return nOutputs_ > 0 ? table_.size() / nOutputs_ : 0; }
+        std::size_t size() const;
+
+      private:
+        friend bool compile_grid(FastForest const& ff, GridForest& grid, std::size_t maxBytes, std::size_t* required);
+
+        std::size_t cellIndex(const FeatureType* array) const;
+
+        int nOutputs_;
+        // the features that are used by the forest, with one grid axis for each of them
+        std::vector<int> features_;
+        // the sorted distinct thresholds of axis i are thresholds_[thresholdOffsets_[i]] up to thresholdOffsets_[i + 1]
+        std::vector<int> thresholdOffsets_;
+        std::vector<FeatureType> thresholds_;
+        // distance between neighboring cells along each axis in the table, in units of nOutputs_ values
+        std::vector<std::size_t> strides_;
+        std::vector<TreeEnsembleResponseType> table_;
+    };
+
+    // A forest compiled to native machine code at runtime, without the need for a compiler. Each tree becomes a
+    // sequence of comparisons with the thresholds as immediate values and conditional jumps, ending in the additions
+    // of the leaf values, which are done in the same order as in FastForest such that the scores are identical. The
+    // code is written to memory that is made executable only after it was written. Native code is generated for
+    // x86-64 on Linux, and on other systems the forest is evaluated with the regular tree traversal instead.
+    class JitForest {
+      public:
+        JitForest();
+        explicit JitForest(FastForest const& ff);
+        // copies compile the forest again
+        JitForest(JitForest const& other);
+        JitForest& operator=(JitForest const& other);
+        ~JitForest();
+
+        void swap(JitForest& other);
+
+        TreeEnsembleResponseType operator()(const FeatureType* array) const;
+        std::vector<TreeEnsembleResponseType> softmax(const FeatureType* array) const;
+        void softmax(const FeatureType* array, TreeEnsembleResponseType* out) const;
+        // raw scores of all classes without softmax transformation, or the single score for binary classification
+        void evaluate(const FeatureType* array, TreeEnsembleResponseType* out) const;
+        // Evaluates nRows rows, with row i read from `array + i * rowStride` and its raw scores written to
+        // `out + i * nOutputs()`
+        void predict(const FeatureType* array, int nRows, int rowStride, TreeEnsembleResponseType* out) const;
+
+        int nClasses() const { return forest_.nClasses(); }
+        int nOutputs() const { return forest_.nOutputs(); }
+        // whether the forest was compiled to native code, otherwise the tree traversal is used
+        bool isNative() const { return code_ != NULL; }
+        // size of the generated machine code in bytes
+        std::size_t codeSize() const { return codeSize_; }
+
+      private:
+        void compile();
+
+        FastForest forest_;
+        void* code_;
+        std::size_t codeSize_;
+    };
+
+    // The evaluation strategies that fastforest::autotune chooses from
+    enum EvaluationEngine {
+        // FastForest::evaluate for each row
+        EngineRowByRow,
+        // FastForest::predict with a tuned number of rows per block and threads
+        EngineBlocked,
+        // ArenaForest::evaluate for each row
+        EngineArena,
+        // GridForest::evaluate for each row, only for forests with a small enough grid
+        EngineGrid,
+        // JitForest::evaluate for each row, only if native code can be generated on this system
+        EngineJit
+    };
+
+    // The fastest evaluation strategy for a forest, as found by fastforest::autotune
+    struct EngineChoice {
+        EngineChoice() : engine(EngineBlocked), blockSize(64), nThreads(1), secondsPerRow(0.), fingerprint(0) {}
+
+        // Saves the choice to a small text file, usually next to the binary model with the ".engine" suffix
+        void write(std::string const& filename) const;
+
+        EvaluationEngine engine;
+        int blockSize;
+        int nThreads;
+        // the measured evaluation time per row
+        double secondsPerRow;
+        // a hash of the forest that was tuned, to detect if the file belongs to another model
+        unsigned int fingerprint;
+    };
+
+    // A forest that evaluates batches of rows with the engine that was chosen for it
+    class TunedForest {
+      public:
+        TunedForest(FastForest const& ff, EngineChoice const& choice);
+
+        // Evaluates nRows rows, with row i read from `array + i * rowStride` and its raw scores written to
+        // `out + i * nOutputs()`. The results are identical for all engines.
+        void predict(const FeatureType* array, int nRows, int rowStride, TreeEnsembleResponseType* out) const;
+
+        EngineChoice const& choice() const { return choice_; }
+        int nOutputs() const { return forest_.nOutputs(); }
+
+      private:
+        FastForest forest_;
+        ArenaForest arena_;
+        GridForest grid_;
+        JitForest jit_;
+        EngineChoice choice_;
+    };
+
+    // A collection of forests that share one input feature space. The feature names of all added forests are unified
+    // into one list, and each forest is stored with its cut indices pointing into this global list. Like that, all
+    // forests can be evaluated on one common input row without gathering the features for each forest separately.
+    struct ForestRegistry {
+        // Adds a forest that was loaded with the given feature names and returns its index in the registry
+        int add(FastForest const& ff, std::vector<std::string> const& features);
+        // Loads a forest from an XGBoost text dump with its own feature names and returns its index in the registry
+        int load_txt(std::string const& txtpath, int nClasses = 2);
+        // Loads several text dumps concurrently with up to nThreads threads, if the library was compiled with C++11,
+        // and adds them in the given order. Returns the index of the first added forest.
+        int load_txt(std::vector<std::string> const& txtpaths, int nClasses = 2, int nThreads = 1);
+
+        // Number of outputs of a forest: one for binary classification, and the number of classes otherwise
+        int nOutputs(int model) const { return forests_[model].baseResponses_.size(); }
+        // Number of outputs of all forests together
+        int nOutputs() const { return outputOffsets_.empty() ? 0 : outputOffsets_.back() + nOutputs(nModels() - 1); }
+        int nModels() const { return forests_.size(); }
+
+        // Evaluates all forests for nRows rows, with row i read from `array + i * rowStride`. The raw scores of
+        // the forests are written next to each other to `out + i * nOutputs()`, without softmax transformation.
+        void evaluate(const FeatureType* array, int nRows, int rowStride, TreeEnsembleResponseType* out) const;
+        // Same as above for a subset of nModels forests, whose outputs are written in the given order
+        void evaluate(const FeatureType* array,
+                      int nRows,
+                      int rowStride,
+                      const int* models,
+                      int nModels,
+                      TreeEnsembleResponseType* out) const;
+
+        // the unified feature names, defining the layout of the input rows
+        std::vector<std::string> features_;
+        std::map<std::string, int> featureIndices_;
+        std::vector<FastForest> forests_;
+        // position of the first output of each forest
+        std::vector<int> outputOffsets_;
+    };
+
+    // With nThreads > 1, the text dump is split into parts with consecutive trees, which are parsed concurrently if
+    // the library was compiled with C++11. The resulting forest is the same as with a single thread.
+    FastForest load_txt(std::string const& txtpath,
+                        std::vector<std::string>& features,
+                        int nClasses = 2,
+                        int nThreads = 1);
     FastForest load_txt(std::istream& is, std::vector<std::string>& features, int nClasses = 2);
+    // Loads a text dump that is already in memory, without copying it into a stream first
+    FastForest load_txt(const void* data,
+                        std::size_t size,
+                        std::vector<std::string>& features,
+                        int nClasses = 2,
+                        int nThreads = 1);
+    // Loads a model in binary format from a file or stream, throwing if the data ends before all arrays are read
     FastForest load_bin(std::string const& txtpath);
     FastForest load_bin(std::istream& is);
+    // Loads a model in binary format that is already in memory, throwing if the buffer is truncated
+    FastForest load_bin(const void* data, std::size_t size);
+    // Loads a model written by FastForest::write_compressed_bin, from a file or from a buffer in memory. Corrupted
+    // input, including sizes larger than the data can hold and out-of-range node indices, throws std::runtime_error.
+    FastForest load_compressed_bin(std::string const& filename);
+    FastForest load_compressed_bin(const void* data, std::size_t size);
+    // Writes the trees that were added to the previous forest to get the updated one, for example by further boosting
+    // rounds, together with the new base responses. The updated forest has to start with the trees of the previous
+    // one, like when both were loaded from dumps of the same training. Apply it with FastForest::append_delta_bin.
+    // The file also stores a hash of the previous forest, so the update can't be applied to a different forest.
+    void write_delta_bin(std::string const& filename, FastForest const& previous, FastForest const& updated);
+    // Sizes of a forest before and after fastforest::compress
+    struct CompressionReport {
+        int nTreesBefore;
+        int nTreesAfter;
+        int nNodesBefore;
+        int nNodesAfter;
+        int nLeavesBefore;
+        int nLeavesAfter;
+        std::size_t bytesBefore;
+        std::size_t bytesAfter;
+    };
+
+    // Returns a compressed copy of the forest, where identical subtrees and leaves are stored only once and splits
+    // that lead to identical subtrees are removed. Trees that collapse to a single leaf are absorbed in the base
+    // responses, like it's done when loading the model. Other than this change in summation order, the predictions
+    // are unchanged. The cover statistics are not kept, since they can't be shared between merged subtrees.
+    FastForest compress(FastForest const& ff, CompressionReport* report = NULL);
+
+    // Compiles a forest to a GridForest if the table and thresholds take at most maxBytes of memory. Otherwise, the
+    // grid is not changed and false is returned. In both cases, the required size is written to `required` if given.
+    bool compile_grid(FastForest const& ff, GridForest& grid, std::size_t maxBytes, std::size_t* required = NULL);
+
+    // Times the available evaluation engines with different block sizes and up to maxThreads threads on the sample
+    // rows, with row i read from `array + i * rowStride`, and returns the fastest. Engines that don't reproduce the
+    // results of FastForest::predict exactly are not considered.
+    EngineChoice autotune(FastForest const& ff, const FeatureType* array, int nRows, int rowStride, int maxThreads = 1);
+
+    // Reads an engine choice saved with EngineChoice::write. Returns false if the file doesn't exist or if it was
+    // tuned for a different forest, in which case the forest should be tuned again.
+    bool load_engine_choice(std::string const& filename, FastForest const& ff, EngineChoice& choice);
+
+    // Sizes and errors of a forest quantized with fastforest::quantize
+    struct QuantizationReport {
+        std::size_t bytesBefore;
+        std::size_t bytesAfter;
+        // largest absolute difference between an original and a quantized leaf value
+        double maxLeafError;
+        // largest absolute difference of the raw scores on the validation rows, zero if there were none
+        double maxPredictionError;
+    };
+
+    // Returns a copy of the forest with the leaf values stored in the given precision. If validation rows are given,
+    // with row i read from `array + i * rowStride`, the largest change of the raw scores on these rows is reported.
+    QuantizedForest quantize(FastForest const& ff,
+                             LeafPrecision precision,
+                             const FeatureType* array = NULL,
+                             int nRows = 0,
+                             int rowStride = 0,
+                             QuantizationReport* report = NULL);
+    // Reads a forest written by QuantizedForest::write_bin
+    QuantizedForest load_quantized_bin(std::string const& filename);
+
+    // Returns a copy of the forest with the nodes of each tree rearranged according to the branch statistics in the
+    // profile, which has to be recorded with the same forest. In each tree, the more frequently taken child of a
+    // node is placed right after it, such that hot paths are stored contiguously. The predictions are unchanged.
+    FastForest optimize_layout(FastForest const& ff, ForestProfile const& profile);
+
 #ifdef EXPERIMENTAL_TMVA_SUPPORT
-    FastForest load_tmva_xml(std::string const& xmlpath, std::vector<std::string>& features);
+    // The trees are read with up to nThreads threads if the library was compiled with C++11
+    FastForest load_tmva_xml(std::string const& xmlpath, std::vector<std::string>& features, int nThreads = 1);
 #endif
 
 }  // namespace fastforest
@@ -0,0 +1,375 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef FastForestBatcher_h
+#define FastForestBatcher_h
+
+#if __cplusplus < 201103L
+#error "fastforest_batcher.h requires C++11 or later"
+#endif
+
+#include "fastforest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fastforest {
+
+    // Collects single rows from many concurrent callers into batches, such that they are evaluated together with
+    // FastForest::predict. The rows are passed through a lock-free queue to a dispatcher thread, which evaluates a
+    // batch as soon as it has maxBatchSize rows, or when the first row in the batch has waited for maxDelay. The
+    // raw scores are returned via futures or callbacks. The callbacks are called on the dispatcher thread, so they
+    // should return quickly. Exceptions thrown by a callback are caught and dropped, such that they can't affect the
+    // other rows of the batch. Submitting blocks only if the queue is full. With nThreads > 1, each batch is split
+    // over the dispatcher and nThreads - 1 worker threads, which are started once with the batcher.
+    class MicroBatcher {
+      public:
+        typedef std::function<void(const TreeEnsembleResponseType* scores)> Callback;
+
+        MicroBatcher(FastForest ff,
+                     int nFeatures,
+                     int maxBatchSize = 64,
+                     std::chrono::microseconds maxDelay = std::chrono::microseconds(50),
+                     int nThreads = 1,
+                     std::size_t queueCapacity = 4096)
+            : forest_(std::move(ff)),
+              nFeatures_(nFeatures),
+              nOut_(forest_.nOutputs()),
+              maxBatchSize_(std::max(maxBatchSize, 1)),
+              maxDelay_(maxDelay),
+              nThreads_(std::max(nThreads, 1)),
+              cells_(roundUpToPowerOfTwo(std::max<std::size_t>(queueCapacity, 2))),
+              mask_(cells_.size() - 1),
+              enqueuePos_(0),
+              dequeuePos_(0),
+              stop_(false),
+              sleeping_(false),
+              workArray_(nullptr),
+              workRows_(0),
+              workOut_(nullptr),
+              workGeneration_(0),
+              nPending_(0),
+              stopWorkers_(false) {
+            for (std::size_t i = 0; i < cells_.size(); ++i) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+                cells_[i].features.resize(nFeatures_);
+            }
+            for (int i = 1; i < nThreads_; ++i) {
+                workers_.emplace_back(&MicroBatcher::work, this, i);
+            }
+            dispatcher_ = std::thread(&MicroBatcher::run, this);
+        }
+        MicroBatcher(MicroBatcher const&) = delete;
+        MicroBatcher& operator=(MicroBatcher const&) = delete;
+
+        // Evaluates the rows that are still queued and stops the dispatcher thread
+        ~MicroBatcher() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_.store(true);
+            }
+            wakeup_.notify_one();
+            dispatcher_.join();
+            {
+                std::lock_guard<std::mutex> lock(workMutex_);
+                stopWorkers_ = true;
+                ++workGeneration_;
+            }
+            workReady_.notify_all();
+            for (std::thread& worker : workers_) {
+                worker.join();
+            }
+        }
+
+        // Queues a copy of the row with nFeatures values. The future gets the nOutputs() raw scores of the row.
+        std::future<std::vector<TreeEnsembleResponseType>> submit(const FeatureType* array) {
+            std::promise<std::vector<TreeEnsembleResponseType>> promise;
+            std::future<std::vector<TreeEnsembleResponseType>> future = promise.get_future();
+            enqueue(array, std::move(promise), Callback());
+            return future;
+        }
+
+        // Queues a copy of the row, and calls the callback with a pointer to its nOutputs() raw scores, which is only
+        // valid during the call, or with nullptr if the evaluation failed
+        void submit(const FeatureType* array, Callback callback) {
+            enqueue(array, std::promise<std::vector<TreeEnsembleResponseType>>(), std::move(callback));
+        }
+
+        int nOutputs() const { return nOut_; }
+
+      private:
+        // A queue entry, with the sequence number of Dmitry Vyukov's bounded queue that tells whether it is filled
+        struct Cell {
+            std::atomic<std::size_t> sequence;
+            std::vector<FeatureType> features;
+            std::promise<std::vector<TreeEnsembleResponseType>> promise;
+            Callback callback;
+        };
+
+        struct Request {
+            std::promise<std::vector<TreeEnsembleResponseType>> promise;
+            Callback callback;
+        };
+
+        static std::size_t roundUpToPowerOfTwo(std::size_t n) {
+            std::size_t result = 1;
+            while (result < n) {
+                result *= 2;
+            }
+            return result;
+        }
+
+        void enqueue(const FeatureType* array,
+                     std::promise<std::vector<TreeEnsembleResponseType>> promise,
+                     Callback callback) {
+            Cell* cell;
+            std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+            for (;;) {
+                cell = &cells_[pos & mask_];
+                const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    // the queue is full, wait for the dispatcher to make room
+                    std::this_thread::yield();
+                    pos = enqueuePos_.load(std::memory_order_relaxed);
+                } else {
+                    pos = enqueuePos_.load(std::memory_order_relaxed);
+                }
+            }
+            std::copy(array, array + nFeatures_, cell->features.begin());
+            cell->promise = std::move(promise);
+            cell->callback = std::move(callback);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+
+            // The mutex is only taken if the dispatcher is idle. The fence makes sure that either the dispatcher sees
+            // the new row before going to sleep, or we see that it sleeps.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping_.load()) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                wakeup_.notify_one();
+            }
+        }
+
+        // Moves the next row into the batch, returns false if the queue is empty. Only used by the dispatcher.
+        bool dequeue(std::vector<FeatureType>& batch, std::vector<Request>& requests) {
+            Cell& cell = cells_[dequeuePos_ & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != dequeuePos_ + 1) {
+                return false;
+            }
+            batch.insert(batch.end(), cell.features.begin(), cell.features.end());
+            Request request;
+            request.promise = std::move(cell.promise);
+            request.callback = std::move(cell.callback);
+            requests.push_back(std::move(request));
+            cell.sequence.store(dequeuePos_ + mask_ + 1, std::memory_order_release);
+            ++dequeuePos_;
+            return true;
+        }
+
+        // Evaluates the rows from iThread * nRows / nThreads_ up to (iThread + 1) * nRows / nThreads_ of the batch
+        void predictSlice(int iThread) {
+            const int begin = static_cast<std::size_t>(workRows_) * iThread / nThreads_;
+            const int end = static_cast<std::size_t>(workRows_) * (iThread + 1) / nThreads_;
+            if (end > begin) {
+                forest_.predict(workArray_ + static_cast<std::size_t>(begin) * nFeatures_,
+                                end - begin,
+                                nFeatures_,
+                                workOut_ + static_cast<std::size_t>(begin) * nOut_,
+                                1);
+            }
+        }
+
+        // Evaluates a batch on the dispatcher thread and the worker threads, and rethrows the first error
+        void predictBatch(const FeatureType* array, int nRows, TreeEnsembleResponseType* out) {
+            workArray_ = array;
+            workRows_ = nRows;
+            workOut_ = out;
+            if (workers_.empty()) {
+                predictSlice(0);
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(workMutex_);
+                nPending_ = workers_.size();
+                workError_ = nullptr;
+                ++workGeneration_;
+            }
+            workReady_.notify_all();
+            std::exception_ptr error;
+            try {
+                predictSlice(0);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::unique_lock<std::mutex> lock(workMutex_);
+            workDone_.wait(lock, [this] { return nPending_ == 0; });
+            if (!error) {
+                error = workError_;
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        // The loop of a worker thread, which evaluates its slice of each batch
+        void work(int iThread) {
+            unsigned int seen = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(workMutex_);
+                    workReady_.wait(lock, [this, seen] { return workGeneration_ != seen; });
+                    seen = workGeneration_;
+                    if (stopWorkers_) {
+                        return;
+                    }
+                }
+                std::exception_ptr error;
+                try {
+                    predictSlice(iThread);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(workMutex_);
+                if (error && !workError_) {
+                    workError_ = error;
+                }
+                if (--nPending_ == 0) {
+                    workDone_.notify_one();
+                }
+            }
+        }
+
+        void run() {
+            std::vector<FeatureType> batch;
+            std::vector<Request> requests;
+            std::vector<TreeEnsembleResponseType> scores;
+            batch.reserve(maxBatchSize_ * nFeatures_);
+            requests.reserve(maxBatchSize_);
+
+            for (;;) {
+                if (!dequeue(batch, requests)) {
+                    if (stop_.load()) {
+                        return;
+                    }
+                    // Nothing to do: sleep until a producer or the destructor wakes us up. The queue is checked
+                    // again after announcing that we sleep, so no row that is enqueued in between gets lost.
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    sleeping_.store(true);
+                    wakeup_.wait(lock, [this] {
+                        return stop_.load() || cells_[dequeuePos_ & mask_].sequence.load() == dequeuePos_ + 1;
+                    });
+                    sleeping_.store(false);
+                    continue;
+                }
+
+                const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + maxDelay_;
+                while (static_cast<int>(requests.size()) < maxBatchSize_) {
+                    if (!dequeue(batch, requests)) {
+                        if (std::chrono::steady_clock::now() >= deadline || stop_.load()) {
+                            break;
+                        }
+                        std::this_thread::yield();
+                    }
+                }
+
+                const int nRows = requests.size();
+                scores.resize(nRows * nOut_);
+                std::exception_ptr error;
+                try {
+                    predictBatch(batch.data(), nRows, scores.data());
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                for (int i = 0; i < nRows; ++i) {
+                    const TreeEnsembleResponseType* rowScores = error ? nullptr : &scores[i * nOut_];
+                    if (requests[i].callback) {
+                        try {
+                            requests[i].callback(rowScores);
+                        } catch (...) {
+                            // an exception must neither terminate the dispatcher nor skip the other requests
+                        }
+                    } else if (error) {
+                        requests[i].promise.set_exception(error);
+                    } else {
+                        requests[i].promise.set_value(
+                            std::vector<TreeEnsembleResponseType>(rowScores, rowScores + nOut_));
+                    }
+                }
+                batch.clear();
+                requests.clear();
+            }
+        }
+
+        const FastForest forest_;
+        const int nFeatures_;
+        const int nOut_;
+        const int maxBatchSize_;
+        const std::chrono::microseconds maxDelay_;
+        const int nThreads_;
+
+        std::vector<Cell> cells_;
+        const std::size_t mask_;
+        alignas(64) std::atomic<std::size_t> enqueuePos_;
+        alignas(64) std::size_t dequeuePos_;
+
+        std::atomic<bool> stop_;
+        std::atomic<bool> sleeping_;
+        std::mutex mutex_;
+        std::condition_variable wakeup_;
+        std::thread dispatcher_;
+
+        // The batch that is split over the worker threads, published by incrementing workGeneration_
+        const FeatureType* workArray_;
+        int workRows_;
+        TreeEnsembleResponseType* workOut_;
+        unsigned int workGeneration_;
+        int nPending_;
+        bool stopWorkers_;
+        std::exception_ptr workError_;
+        std::mutex workMutex_;
+        std::condition_variable workReady_;
+        std::condition_variable workDone_;
+        std::vector<std::thread> workers_;
+    };
+
+}  // namespace fastforest
+
+#endif
@@ -0,0 +1,123 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef FastForestC_h
+#define FastForestC_h
+
+/* C interface to the FastForest library, for using it from other languages without depending on the C++ ABI.
+ *
+ * A forest is referred to by an opaque pointer. Functions that can fail return NULL or a nonzero status, and write
+ * a null-terminated error message to the `error` buffer of size `errorSize` if it is not NULL. The batch functions
+ * evaluate all rows in one call, with row i read from `array + i * rowStride`. */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct fastforest_forest fastforest_forest;
+
+/* Loads an XGBoost text dump. The features are the names of the input columns in order. If features is NULL, an
+ * order is determined automatically, which can be queried with fastforest_feature_name. */
+fastforest_forest* fastforest_load_txt(const char* path,
+                                       const char* const* features,
+                                       int nFeatures,
+                                       int nClasses,
+                                       char* error,
+                                       size_t errorSize);
+
+/* Like fastforest_load_txt, but reads the text dump from a buffer in memory. */
+fastforest_forest* fastforest_load_txt_buffer(const char* text,
+                                              size_t size,
+                                              const char* const* features,
+                                              int nFeatures,
+                                              int nClasses,
+                                              char* error,
+                                              size_t errorSize);
+
+/* Loads a model in FastForest binary format from a file or from a buffer in memory. The feature names are not
+ * stored in the binary format, so they are f0, f1, ... in the order of the input columns. */
+fastforest_forest* fastforest_load_bin(const char* path, char* error, size_t errorSize);
+fastforest_forest* fastforest_load_bin_buffer(const void* data, size_t size, char* error, size_t errorSize);
+
+int fastforest_write_bin(const fastforest_forest* forest, const char* path, char* error, size_t errorSize);
+
+void fastforest_free(fastforest_forest* forest);
+
+/* The following functions return 0, or NULL for the feature name, if the forest is NULL. */
+int fastforest_n_features(const fastforest_forest* forest);
+const char* fastforest_feature_name(const fastforest_forest* forest, int index);
+int fastforest_n_classes(const fastforest_forest* forest);
+int fastforest_n_trees(const fastforest_forest* forest);
+/* Number of values per row written by fastforest_predict: one for binary classification, and the number of classes
+ * otherwise. */
+int fastforest_n_outputs(const fastforest_forest* forest);
+
+/* Writes the raw scores of nRows rows to `out + i * fastforest_n_outputs(forest)`, using nThreads threads. */
+int fastforest_predict(const fastforest_forest* forest,
+                       const float* array,
+                       int nRows,
+                       int rowStride,
+                       float* out,
+                       int nThreads,
+                       char* error,
+                       size_t errorSize);
+
+/* Like fastforest_predict, but the scores are accumulated in double precision. */
+int fastforest_predict_double(const fastforest_forest* forest,
+                              const float* array,
+                              int nRows,
+                              int rowStride,
+                              double* out,
+                              int nThreads,
+                              char* error,
+                              size_t errorSize);
+
+/* Like fastforest_predict, but with the softmax transformation applied to the scores of multiclassification models. */
+int fastforest_softmax(const fastforest_forest* forest,
+                       const float* array,
+                       int nRows,
+                       int rowStride,
+                       float* out,
+                       int nThreads,
+                       char* error,
+                       size_t errorSize);
+
+/* Writes the leaf index of each row in every tree to `out + i * fastforest_n_trees(forest)`. */
+int fastforest_predict_leaves(const fastforest_forest* forest,
+                              const float* array,
+                              int nRows,
+                              int rowStride,
+                              int* out,
+                              char* error,
+                              size_t errorSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
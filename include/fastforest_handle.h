@@ -0,0 +1,131 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef FastForestHandle_h
+#define FastForestHandle_h
+
+#if __cplusplus < 201103L
+#error "fastforest_handle.h requires C++11 or later"
+#endif
+
+#include "fastforest.h"
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace fastforest {
+
+    // Thread-safe handle to a FastForest that can be replaced while other threads are evaluating it, similar to
+    // read-copy-update. Readers never take a lock: they pin the current forest by incrementing a counter for the
+    // current epoch. A writer publishes a new forest with an atomic pointer swap, advances the epoch, and deletes the
+    // old forest only after all readers that could still see it have unpinned it (the grace period).
+    class ForestHandle {
+      public:
+        // Keeps the forest that was current at construction time alive until destruction.
+        class Pin {
+          public:
+            Pin(Pin&& other) : counter_(other.counter_), forest_(other.forest_) { other.counter_ = nullptr; }
+            Pin(Pin const&) = delete;
+            Pin& operator=(Pin const&) = delete;
+            ~Pin() {
+                if (counter_) {
+                    counter_->fetch_sub(1, std::memory_order_release);
+                }
+            }
+
+            FastForest const& operator*() const { return *forest_; }
+            FastForest const* operator->() const { return forest_; }
+
+          private:
+            friend class ForestHandle;
+            Pin(std::atomic<long>* counter, FastForest const* forest) : counter_(counter), forest_(forest) {}
+
+            std::atomic<long>* counter_;
+            FastForest const* forest_;
+        };
+
+        explicit ForestHandle(FastForest ff) : current_(new FastForest(std::move(ff))), epoch_(0) {
+            readers_[0].count = 0;
+            readers_[1].count = 0;
+        }
+        ForestHandle(ForestHandle const&) = delete;
+        ForestHandle& operator=(ForestHandle const&) = delete;
+        ~ForestHandle() { delete current_.load(); }
+
+        Pin pin() const {
+            for (;;) {
+                const unsigned int epoch = epoch_.load();
+                std::atomic<long>& counter = readers_[epoch & 1].count;
+                counter.fetch_add(1);
+                // If a writer advanced the epoch in the meantime, it might not wait for this counter anymore
+                if (epoch_.load() == epoch) {
+                    return Pin(&counter, current_.load());
+                }
+                counter.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        TreeEnsembleResponseType operator()(const FeatureType* array) const { return (*pin())(array); }
+
+        // Replaces the forest, and blocks until the old one is not used by any reader anymore to delete it.
+        void publish(FastForest ff) {
+            FastForest* next = new FastForest(std::move(ff));
+            std::lock_guard<std::mutex> lock(writerMutex_);
+            FastForest* old = current_.exchange(next);
+            const unsigned int epoch = epoch_.fetch_add(1);
+            // Readers that pinned after the epoch advance can only see the new forest
+            while (readers_[epoch & 1].count.load(std::memory_order_acquire) != 0) {
+                std::this_thread::yield();
+            }
+            delete old;
+        }
+
+        void reload_bin(std::string const& filename) { publish(load_bin(filename)); }
+
+        // Loads and publishes a new forest in the background, including the wait for the grace period.
+        std::future<void> reload_bin_async(std::string const& filename) {
+            return std::async(std::launch::async, &ForestHandle::reload_bin, this, filename);
+        }
+
+      private:
+        // each counter on its own cache line to avoid false sharing
+        struct alignas(64) ReaderCounter {
+            std::atomic<long> count;
+        };
+
+        std::atomic<FastForest*> current_;
+        std::atomic<unsigned int> epoch_;
+        mutable ReaderCounter readers_[2];
+        std::mutex writerMutex_;
+    };
+
+}  // namespace fastforest
+
+#endif
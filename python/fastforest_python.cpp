@@ -0,0 +1,459 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// Python extension module to evaluate FastForest models on whole arrays at once.
+//
+// The input arrays are accessed via the buffer protocol, so any 2D float32 array that exposes its memory (like numpy
+// arrays) can be passed without copying. The evaluation runs without holding the GIL. The outputs are numpy arrays if
+// numpy is installed, and memoryviews otherwise, but numpy is not needed to compile the module.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <fastforest.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct PyFastForest {
+        PyObject_HEAD fastforest::FastForest* forest;
+        PyObject* features;
+    };
+
+    // Rows are gathered in blocks of this size if the input is not row-contiguous, e.g. for Fortran-ordered arrays
+    const Py_ssize_t gatherBlockSize = 1024;
+
+    // A 2D float32 input array, or a 1D array that is a single row
+    class InputRows {
+      public:
+        InputRows() : acquired_(false) {}
+        ~InputRows() {
+            if (acquired_) {
+                PyBuffer_Release(&view_);
+            }
+        }
+
+        bool acquire(PyObject* obj, int nFeatures) {
+            if (PyObject_GetBuffer(obj, &view_, PyBUF_STRIDES | PyBUF_FORMAT) != 0) {
+                return false;
+            }
+            acquired_ = true;
+            const std::string format = view_.format ? view_.format : "f";
+            if (view_.itemsize != sizeof(float) || (format != "f" && format != "<f" && format != "=f")) {
+                PyErr_SetString(PyExc_TypeError, "the input array needs to have dtype float32");
+                return false;
+            }
+            if (view_.ndim != 1 && view_.ndim != 2) {
+                PyErr_SetString(PyExc_ValueError, "the input array needs to be one- or two-dimensional");
+                return false;
+            }
+            nRows_ = view_.ndim == 2 ? view_.shape[0] : 1;
+            nColumns_ = view_.shape[view_.ndim - 1];
+            rowStride_ = view_.ndim == 2 ? view_.strides[0] : 0;
+            columnStride_ = view_.strides[view_.ndim - 1];
+            if (nColumns_ < nFeatures) {
+                PyErr_Format(PyExc_ValueError, "the input array has %zd columns, but the model uses %d features",
+                             nColumns_, nFeatures);
+                return false;
+            }
+            if (nRows_ > INT_MAX) {
+                PyErr_SetString(PyExc_ValueError, "the input array has too many rows");
+                return false;
+            }
+            return true;
+        }
+
+        int nRows() const { return nRows_; }
+        int nColumns() const { return nColumns_; }
+
+        // True if the rows can be used directly, with a row stride that is a multiple of the float size
+        bool isRowContiguous() const {
+            return columnStride_ == sizeof(float) && rowStride_ >= 0 && rowStride_ % sizeof(float) == 0 &&
+                   rowStride_ / sizeof(float) <= INT_MAX;
+        }
+        const float* data() const { return static_cast<const float*>(view_.buf); }
+        int rowStride() const { return rowStride_ / sizeof(float); }
+
+        // Copies the rows [begin, end) contiguously into the buffer
+        void gather(Py_ssize_t begin, Py_ssize_t end, float* buffer) const {
+            const char* base = static_cast<const char*>(view_.buf);
+            for (Py_ssize_t j = 0; j < nColumns_; ++j) {
+                const char* column = base + j * columnStride_;
+                for (Py_ssize_t i = begin; i < end; ++i) {
+                    buffer[(i - begin) * nColumns_ + j] = *reinterpret_cast<const float*>(column + i * rowStride_);
+                }
+            }
+        }
+
+      private:
+        Py_buffer view_;
+        bool acquired_;
+        Py_ssize_t nRows_;
+        Py_ssize_t nColumns_;
+        Py_ssize_t rowStride_;
+        Py_ssize_t columnStride_;
+    };
+
+    // Creates a new C-contiguous output array, preferably a numpy array
+    PyObject* newArray(Py_ssize_t nRows, Py_ssize_t nColumns, bool squeeze, char typecode, void** data) {
+        PyObject* result = NULL;
+        PyObject* numpy = PyImport_ImportModule("numpy");
+        if (numpy) {
+            const char* dtype = typecode == 'f' ? "float32" : "int32";
+            result = squeeze ? PyObject_CallMethod(numpy, "empty", "(n)s", nRows, dtype)
+                             : PyObject_CallMethod(numpy, "empty", "(nn)s", nRows, nColumns, dtype);
+            Py_DECREF(numpy);
+        } else {
+            PyErr_Clear();
+            PyObject* bytes = PyByteArray_FromStringAndSize(NULL, nRows * nColumns * 4);
+            PyObject* view = bytes ? PyMemoryView_FromObject(bytes) : NULL;
+            Py_XDECREF(bytes);
+            if (view) {
+                const char format[] = {typecode, '\0'};
+                result = squeeze ? PyObject_CallMethod(view, "cast", "s(n)", format, nRows)
+                                 : PyObject_CallMethod(view, "cast", "s(nn)", format, nRows, nColumns);
+                Py_DECREF(view);
+            }
+        }
+        if (!result) {
+            return NULL;
+        }
+        Py_buffer buffer;
+        if (PyObject_GetBuffer(result, &buffer, PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE) != 0) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        *data = buffer.buf;
+        // the result keeps the memory alive
+        PyBuffer_Release(&buffer);
+        return result;
+    }
+
+    enum Mode { Scores, Probabilities, Leaves, Contributions };
+
+    void evaluateRows(fastforest::FastForest const& forest,
+                      const float* array,
+                      int nRows,
+                      int rowStride,
+                      int nColumns,
+                      Mode mode,
+                      int nThreads,
+                      float* out) {
+        if (mode == Contributions) {
+            forest.predictContributions(array, nRows, rowStride, nColumns, out, nThreads);
+            return;
+        }
+        forest.predict(array, nRows, rowStride, out, nThreads);
+        const int nOut = forest.nOutputs();
+        if (mode == Probabilities) {
+            for (int i = 0; i < nRows; ++i) {
+                fastforest::details::softmaxTransformInplace(out + static_cast<std::size_t>(i) * nOut, nOut);
+            }
+        }
+    }
+
+    void evaluateRows(fastforest::FastForest const& forest,
+                      const float* array,
+                      int nRows,
+                      int rowStride,
+                      int /*nColumns*/,
+                      Mode /*mode*/,
+                      int nThreads,
+                      int* out) {
+        forest.predictLeaves(array, nRows, rowStride, out, nThreads);
+    }
+
+    // Evaluates all input rows, with `nOut` output values of type T per row
+    template <class T>
+    void evaluateRows(
+        fastforest::FastForest const& forest, InputRows const& rows, Mode mode, int nThreads, int nOut, T* out) {
+        if (rows.isRowContiguous()) {
+            evaluateRows(forest, rows.data(), rows.nRows(), rows.rowStride(), rows.nColumns(), mode, nThreads, out);
+            return;
+        }
+        std::vector<float> buffer(gatherBlockSize * rows.nColumns());
+        for (Py_ssize_t begin = 0; begin < rows.nRows(); begin += gatherBlockSize) {
+            const Py_ssize_t end = std::min(begin + gatherBlockSize, static_cast<Py_ssize_t>(rows.nRows()));
+            rows.gather(begin, end, buffer.data());
+            const int nColumns = rows.nColumns();
+            evaluateRows(forest, buffer.data(), end - begin, nColumns, nColumns, mode, nThreads, out + begin * nOut);
+        }
+    }
+
+    template <class T>
+    PyObject* evaluate(PyFastForest* self, PyObject* args, PyObject* kwargs, Mode mode) {
+        static const char* keywords[] = {"X", "n_threads", NULL};
+        PyObject* input = NULL;
+        int nThreads = 1;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|i", const_cast<char**>(keywords), &input, &nThreads)) {
+            return NULL;
+        }
+        fastforest::FastForest const& forest = *self->forest;
+        if (mode == Probabilities && forest.nOutputs() == 1) {
+            PyErr_SetString(PyExc_ValueError,
+                            "binary classification models don't support softmax evaluation, use predict() instead");
+            return NULL;
+        }
+
+        InputRows rows;
+        if (!rows.acquire(input, PyList_Size(self->features))) {
+            return NULL;
+        }
+
+        int nOut = mode == Leaves ? forest.nTrees() : forest.nOutputs();
+        if (mode == Contributions) {
+            nOut *= rows.nColumns() + 1;
+        }
+        // binary classification scores are returned as a one-dimensional array
+        const bool squeeze = nOut == 1;
+
+        T* out = NULL;
+        const char typecode = mode == Leaves ? 'i' : 'f';
+        PyObject* result = newArray(rows.nRows(), nOut, squeeze, typecode, reinterpret_cast<void**>(&out));
+        if (!result) {
+            return NULL;
+        }
+
+        std::string error;
+        Py_BEGIN_ALLOW_THREADS;
+        try {
+            evaluateRows(forest, rows, mode, nThreads, nOut, out);
+        } catch (std::exception const& e) {
+            error = e.what();
+        }
+        Py_END_ALLOW_THREADS;
+        if (!error.empty()) {
+            Py_DECREF(result);
+            PyErr_SetString(PyExc_RuntimeError, error.c_str());
+            return NULL;
+        }
+        return result;
+    }
+
+    PyObject* predict(PyFastForest* self, PyObject* args, PyObject* kwargs) {
+        return evaluate<float>(self, args, kwargs, Scores);
+    }
+
+    PyObject* softmax(PyFastForest* self, PyObject* args, PyObject* kwargs) {
+        return evaluate<float>(self, args, kwargs, Probabilities);
+    }
+
+    PyObject* predictLeaves(PyFastForest* self, PyObject* args, PyObject* kwargs) {
+        return evaluate<int>(self, args, kwargs, Leaves);
+    }
+
+    PyObject* predictContributions(PyFastForest* self, PyObject* args, PyObject* kwargs) {
+        return evaluate<float>(self, args, kwargs, Contributions);
+    }
+
+    PyObject* writeBin(PyFastForest* self, PyObject* args) {
+        const char* filename = NULL;
+        if (!PyArg_ParseTuple(args, "s", &filename)) {
+            return NULL;
+        }
+        try {
+            self->forest->write_bin(filename);
+        } catch (std::exception const& e) {
+            PyErr_SetString(PyExc_RuntimeError, e.what());
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    PyObject* getNTrees(PyFastForest* self, void*) { return PyLong_FromLong(self->forest->nTrees()); }
+    PyObject* getNClasses(PyFastForest* self, void*) { return PyLong_FromLong(self->forest->nClasses()); }
+    PyObject* getNOutputs(PyFastForest* self, void*) { return PyLong_FromLong(self->forest->nOutputs()); }
+    PyObject* getFeatures(PyFastForest* self, void*) { return PyList_GetSlice(self->features, 0, PY_SSIZE_T_MAX); }
+
+    void dealloc(PyFastForest* self) {
+        delete self->forest;
+        Py_XDECREF(self->features);
+        Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+    }
+
+    PyMethodDef methods[] = {
+        {"predict",
+         reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(predict)),
+         METH_VARARGS | METH_KEYWORDS,
+         "predict(X, n_threads=1)\n--\n\n"
+         "Raw scores for the rows of the 2D float32 array X, with one column per class for multiclassification."},
+        {"softmax",
+         reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(softmax)),
+         METH_VARARGS | METH_KEYWORDS,
+         "softmax(X, n_threads=1)\n--\n\n"
+         "Class probabilities for the rows of X, for multiclassification models."},
+        {"predict_leaves",
+         reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(predictLeaves)),
+         METH_VARARGS | METH_KEYWORDS,
+         "predict_leaves(X)\n--\n\n"
+         "Index of the leaf that each row of X ends up in for every tree, like pred_leaf=True in XGBoost."},
+        {"predict_contributions",
+         reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(predictContributions)),
+         METH_VARARGS | METH_KEYWORDS,
+         "predict_contributions(X, n_threads=1)\n--\n\n"
+         "SHAP feature contributions for the rows of X, like pred_contribs=True in XGBoost."},
+        {"write_bin", reinterpret_cast<PyCFunction>(writeBin), METH_VARARGS, "Saves the model in binary format."},
+        {NULL, NULL, 0, NULL}};
+
+    PyGetSetDef getters[] = {
+        {const_cast<char*>("n_trees"), reinterpret_cast<getter>(getNTrees), NULL, NULL, NULL},
+        {const_cast<char*>("n_classes"), reinterpret_cast<getter>(getNClasses), NULL, NULL, NULL},
+        {const_cast<char*>("n_outputs"), reinterpret_cast<getter>(getNOutputs), NULL, NULL, NULL},
+        {const_cast<char*>("features"), reinterpret_cast<getter>(getFeatures), NULL, NULL, NULL},
+        {NULL, NULL, NULL, NULL, NULL}};
+
+    PyTypeObject fastForestType = {PyVarObject_HEAD_INIT(NULL, 0) "fastforest.FastForest"};
+
+    // Wraps a loaded forest into a new Python object, taking ownership of the features list
+    PyObject* wrap(fastforest::FastForest const& forest, PyObject* features) {
+        PyFastForest* self = PyObject_New(PyFastForest, &fastForestType);
+        if (!self) {
+            Py_DECREF(features);
+            return NULL;
+        }
+        self->forest = new fastforest::FastForest(forest);
+        self->features = features;
+        return reinterpret_cast<PyObject*>(self);
+    }
+
+    PyObject* toList(std::vector<std::string> const& strings) {
+        PyObject* list = PyList_New(strings.size());
+        for (std::size_t i = 0; list && i < strings.size(); ++i) {
+            PyList_SET_ITEM(list, i, PyUnicode_FromString(strings[i].c_str()));
+        }
+        return list;
+    }
+
+    PyObject* loadTxt(PyObject*, PyObject* args, PyObject* kwargs) {
+        static const char* keywords[] = {"path", "features", "n_classes", NULL};
+        const char* path = NULL;
+        PyObject* featureNames = NULL;
+        int nClasses = 2;
+        if (!PyArg_ParseTupleAndKeywords(
+                args, kwargs, "s|Oi", const_cast<char**>(keywords), &path, &featureNames, &nClasses)) {
+            return NULL;
+        }
+        std::vector<std::string> features;
+        if (featureNames && featureNames != Py_None) {
+            PyObject* sequence = PySequence_Fast(featureNames, "features needs to be a sequence of strings");
+            if (!sequence) {
+                return NULL;
+            }
+            for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(sequence); ++i) {
+                const char* name = PyUnicode_AsUTF8(PySequence_Fast_GET_ITEM(sequence, i));
+                if (!name) {
+                    Py_DECREF(sequence);
+                    return NULL;
+                }
+                features.push_back(name);
+            }
+            Py_DECREF(sequence);
+        }
+        try {
+            fastforest::FastForest forest = fastforest::load_txt(path, features, nClasses);
+            PyObject* list = toList(features);
+            return list ? wrap(forest, list) : NULL;
+        } catch (std::exception const& e) {
+            PyErr_SetString(PyExc_RuntimeError, e.what());
+            return NULL;
+        }
+    }
+
+    PyObject* loadBin(PyObject*, PyObject* args) {
+        const char* path = NULL;
+        if (!PyArg_ParseTuple(args, "s", &path)) {
+            return NULL;
+        }
+        try {
+            fastforest::FastForest forest = fastforest::load_bin(path);
+            // the binary format doesn't store the feature names
+            int nFeatures = 0;
+            for (std::size_t i = 0; i < forest.cutIndices_.size(); ++i) {
+                nFeatures = std::max(nFeatures, static_cast<int>(forest.cutIndices_[i]) + 1);
+            }
+            std::vector<std::string> features;
+            for (int i = 0; i < nFeatures; ++i) {
+                features.push_back("f" + std::to_string(i));
+            }
+            PyObject* list = toList(features);
+            return list ? wrap(forest, list) : NULL;
+        } catch (std::exception const& e) {
+            PyErr_SetString(PyExc_RuntimeError, e.what());
+            return NULL;
+        }
+    }
+
+    PyMethodDef moduleMethods[] = {
+        {"load_txt",
+         reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(loadTxt)),
+         METH_VARARGS | METH_KEYWORDS,
+         "load_txt(path, features=None, n_classes=2)\n--\n\n"
+         "Loads an XGBoost text dump. The features are the names of the input columns in order, and are determined "
+         "automatically if they are not given."},
+        {"load_bin",
+         reinterpret_cast<PyCFunction>(loadBin),
+         METH_VARARGS,
+         "Loads a model in FastForest binary format."},
+        {NULL, NULL, 0, NULL}};
+
+    PyModuleDef moduleDef = {PyModuleDef_HEAD_INIT,
+                             "fastforest",
+                             "Fast evaluation of XGBoost models on numpy arrays.",
+                             -1,
+                             moduleMethods,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL};
+
+}  // namespace
+
+PyMODINIT_FUNC PyInit_fastforest() {
+    fastForestType.tp_basicsize = sizeof(PyFastForest);
+    fastForestType.tp_dealloc = reinterpret_cast<destructor>(dealloc);
+    fastForestType.tp_flags = Py_TPFLAGS_DEFAULT;
+    fastForestType.tp_doc = "A FastForest model, created with load_txt or load_bin.";
+    fastForestType.tp_methods = methods;
+    fastForestType.tp_getset = getters;
+    if (PyType_Ready(&fastForestType) < 0) {
+        return NULL;
+    }
+    PyObject* module = PyModule_Create(&moduleDef);
+    if (!module) {
+        return NULL;
+    }
+    Py_INCREF(&fastForestType);
+    if (PyModule_AddObject(module, "FastForest", reinterpret_cast<PyObject*>(&fastForestType)) < 0) {
+        Py_DECREF(&fastForestType);
+        Py_DECREF(module);
+        return NULL;
+    }
+    return module;
+}
@@ -0,0 +1,307 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+#include "common_details.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+using namespace fastforest;
+
+namespace {
+
+    const std::size_t cacheLineSize = 64;
+    const std::size_t hugePageSize = 2 * 1024 * 1024;
+
+    std::size_t readSize(const char* data, std::size_t offset) {
+        int value;
+        std::memcpy(&value, data + offset, sizeof(int));
+        if (value < 0) {
+            throw std::runtime_error("Error in fastforest::load_arena_bin : negative array size");
+        }
+        return value;
+    }
+
+    // Checks that the data is large enough for the arrays in its header, such that evaluation can't read past it
+    void checkSize(const char* data, std::size_t size, std::string const& problem) {
+        const std::string message = "Error in fastforest::load_arena_bin : " + problem;
+        if (size < 3 * sizeof(int)) {
+            throw std::runtime_error(message);
+        }
+        const std::size_t nRootNodes = readSize(data, 0);
+        const std::size_t nNodes = readSize(data, sizeof(int));
+        const std::size_t nLeaves = readSize(data, 2 * sizeof(int));
+        const std::size_t baseOffset = 3 * sizeof(int) + nRootNodes * 2 * sizeof(int) +
+                                       nNodes * (sizeof(CutIndexType) + sizeof(FeatureType) + 2 * sizeof(int)) +
+                                       nLeaves * sizeof(TreeResponseType);
+        if (size < baseOffset + sizeof(int) ||
+            size < baseOffset + sizeof(int) + readSize(data, baseOffset) * sizeof(TreeEnsembleResponseType)) {
+            throw std::runtime_error(message);
+        }
+    }
+
+    int readInt(const char* data, std::size_t offset) {
+        int value;
+        std::memcpy(&value, data + offset, sizeof(int));
+        return value;
+    }
+
+    template <class Type_t>
+    void appendArray(char*& pos, std::vector<Type_t> const& vec) {
+        if (!vec.empty()) {
+            std::memcpy(pos, &vec[0], vec.size() * sizeof(Type_t));
+        }
+        pos += vec.size() * sizeof(Type_t);
+    }
+
+    void appendInt(char*& pos, int value) {
+        std::memcpy(pos, &value, sizeof(int));
+        pos += sizeof(int);
+    }
+
+}  // namespace
+
+fastforest::ArenaForest::ArenaForest() : memory_(NULL), data_(NULL), size_(0) { setPointers(); }
+
+fastforest::ArenaForest::ArenaForest(FastForest const& ff) : memory_(NULL), data_(NULL), size_(0) {
+    const bool hasCovers = !ff.nodeCovers_.empty();
+    const int nRootNodes = ff.rootIndices_.size();
+    const int nNodes = ff.cutValues_.size();
+    const int nLeaves = ff.responses_.size();
+    const int nBaseResponses = ff.baseResponses_.size();
+
+    allocate(4 * sizeof(int) + nRootNodes * 2 * sizeof(int) + nNodes * (sizeof(CutIndexType) + sizeof(FeatureType)) +
+             nNodes * 2 * sizeof(int) + nLeaves * sizeof(TreeResponseType) +
+             nBaseResponses * sizeof(TreeEnsembleResponseType) +
+             (hasCovers ? (nNodes + nLeaves) * sizeof(TreeResponseType) : 0));
+
+    // same layout as in FastForest::write_bin
+    char* pos = data_;
+    appendInt(pos, nRootNodes);
+    appendInt(pos, nNodes);
+    appendInt(pos, nLeaves);
+    appendArray(pos, ff.rootIndices_);
+    appendArray(pos, ff.cutIndices_);
+    appendArray(pos, ff.cutValues_);
+    appendArray(pos, ff.leftIndices_);
+    appendArray(pos, ff.rightIndices_);
+    appendArray(pos, ff.responses_);
+    appendArray(pos, ff.treeNumbers_);
+    appendInt(pos, nBaseResponses);
+    appendArray(pos, ff.baseResponses_);
+    if (hasCovers) {
+        appendArray(pos, ff.nodeCovers_);
+        appendArray(pos, ff.leafCovers_);
+    }
+
+    setPointers();
+}
+
+fastforest::ArenaForest::ArenaForest(ArenaForest const& other) : memory_(NULL), data_(NULL), size_(0) {
+    allocate(other.size_);
+    if (size_ > 0) {
+        std::memcpy(data_, other.data_, size_);
+    }
+    setPointers();
+}
+
+fastforest::ArenaForest& fastforest::ArenaForest::operator=(ArenaForest const& other) {
+    ArenaForest copy(other);
+    swap(copy);
+    return *this;
+}
+
+fastforest::ArenaForest::~ArenaForest() { std::free(memory_); }
+
+void fastforest::ArenaForest::swap(ArenaForest& other) {
+    std::swap(memory_, other.memory_);
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    setPointers();
+    other.setPointers();
+}
+
+void fastforest::ArenaForest::allocate(std::size_t size) {
+    // Large forests are aligned to huge pages, such that the kernel can back them with huge pages where available
+    const std::size_t alignment = size >= hugePageSize ? hugePageSize : cacheLineSize;
+    memory_ = static_cast<char*>(std::malloc(size + alignment));
+    if (!memory_) {
+        throw std::bad_alloc();
+    }
+    const std::size_t address = reinterpret_cast<std::size_t>(memory_);
+    data_ = memory_ + (alignment - address % alignment) % alignment;
+    size_ = size;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (alignment == hugePageSize) {
+        madvise(data_, size - size % hugePageSize, MADV_HUGEPAGE);
+    }
+#endif
+}
+
+void fastforest::ArenaForest::setPointers() {
+    if (size_ == 0) {
+        nRootNodes_ = nNodes_ = nLeaves_ = nBaseResponses_ = 0;
+        rootIndices_ = leftIndices_ = rightIndices_ = treeNumbers_ = NULL;
+        cutIndices_ = NULL;
+        cutValues_ = NULL;
+        responses_ = NULL;
+        baseResponses_ = NULL;
+        return;
+    }
+
+    nRootNodes_ = readInt(data_, 0);
+    nNodes_ = readInt(data_, sizeof(int));
+    nLeaves_ = readInt(data_, 2 * sizeof(int));
+
+    const char* pos = data_ + 3 * sizeof(int);
+    rootIndices_ = reinterpret_cast<const int*>(pos);
+    pos += nRootNodes_ * sizeof(int);
+    cutIndices_ = reinterpret_cast<const CutIndexType*>(pos);
+    pos += nNodes_ * sizeof(CutIndexType);
+    cutValues_ = reinterpret_cast<const FeatureType*>(pos);
+    pos += nNodes_ * sizeof(FeatureType);
+    leftIndices_ = reinterpret_cast<const int*>(pos);
+    pos += nNodes_ * sizeof(int);
+    rightIndices_ = reinterpret_cast<const int*>(pos);
+    pos += nNodes_ * sizeof(int);
+    responses_ = reinterpret_cast<const TreeResponseType*>(pos);
+    pos += nLeaves_ * sizeof(TreeResponseType);
+    treeNumbers_ = reinterpret_cast<const int*>(pos);
+    pos += nRootNodes_ * sizeof(int);
+    nBaseResponses_ = readInt(pos, 0);
+    pos += sizeof(int);
+    baseResponses_ = reinterpret_cast<const TreeEnsembleResponseType*>(pos);
+}
+
+void fastforest::ArenaForest::evaluate(const FeatureType* array, TreeEnsembleResponseType* out) const {
+    const int nOut = nBaseResponses_;
+    for (int i = 0; i < nOut; ++i) {
+        out[i] = baseResponses_[i];
+    }
+    for (int iTree = 0; iTree < nRootNodes_; ++iTree) {
+        const int leaf =
+            detail::evaluateTree(rootIndices_[iTree], array, cutIndices_, cutValues_, leftIndices_, rightIndices_);
+        out[nOut == 1 ? 0 : treeNumbers_[iTree] % nOut] += responses_[leaf];
+    }
+}
+
+TreeEnsembleResponseType fastforest::ArenaForest::operator()(const FeatureType* array) const {
+    TreeEnsembleResponseType out = baseResponses_[0];
+    for (int iTree = 0; iTree < nRootNodes_; ++iTree) {
+        out += responses_[detail::evaluateTree(
+            rootIndices_[iTree], array, cutIndices_, cutValues_, leftIndices_, rightIndices_)];
+    }
+    return out;
+}
+
+std::vector<TreeEnsembleResponseType> fastforest::ArenaForest::softmax(const FeatureType* array) const {
+    std::vector<TreeEnsembleResponseType> out(nClasses());
+    softmax(array, out.data());
+    return out;
+}
+
+void fastforest::ArenaForest::softmax(const FeatureType* array, TreeEnsembleResponseType* out) const {
+    if (nClasses() <= 2) {
+        throw std::runtime_error(
+            "Error in ArenaForest::softmax : binary classification models don't support softmax evaluation.");
+    }
+    evaluate(array, out);
+    fastforest::details::softmaxTransformInplace(out, nClasses());
+}
+
+FastForest fastforest::ArenaForest::toFastForest() const {
+    FastForest ff;
+    ff.rootIndices_.assign(rootIndices_, rootIndices_ + nRootNodes_);
+    ff.cutIndices_.assign(cutIndices_, cutIndices_ + nNodes_);
+    ff.cutValues_.assign(cutValues_, cutValues_ + nNodes_);
+    ff.leftIndices_.assign(leftIndices_, leftIndices_ + nNodes_);
+    ff.rightIndices_.assign(rightIndices_, rightIndices_ + nNodes_);
+    ff.responses_.assign(responses_, responses_ + nLeaves_);
+    ff.treeNumbers_.assign(treeNumbers_, treeNumbers_ + nRootNodes_);
+    ff.baseResponses_.assign(baseResponses_, baseResponses_ + nBaseResponses_);
+    const TreeResponseType* covers = reinterpret_cast<const TreeResponseType*>(baseResponses_ + nBaseResponses_);
+    if (reinterpret_cast<const char*>(covers) < data_ + size_) {
+        ff.nodeCovers_.assign(covers, covers + nNodes_);
+        ff.leafCovers_.assign(covers + nNodes_, covers + nNodes_ + nLeaves_);
+    }
+    ff.prepareLeafIndices();
+    return ff;
+}
+
+void fastforest::ArenaForest::write_bin(std::string const& filename) const {
+    std::ofstream os(filename.c_str(), std::ios::binary);
+    os.write(data_, size_);
+}
+
+ArenaForest fastforest::load_arena_bin(std::string const& filename) {
+    std::ifstream is(filename.c_str(), std::ios::binary);
+    if (!is) {
+        throw std::runtime_error("Error in fastforest::load_arena_bin : can't open " + filename);
+    }
+    is.seekg(0, std::ios::end);
+    const std::streamoff end = is.tellg();
+    is.seekg(0, std::ios::beg);
+    if (end < 0 || !is) {
+        throw std::runtime_error("Error in fastforest::load_arena_bin : can't determine the size of " + filename);
+    }
+    const std::size_t size = static_cast<std::size_t>(end);
+
+    ArenaForest forest;
+    forest.allocate(size);
+    if (!is.read(forest.data_, size)) {
+        throw std::runtime_error("Error in fastforest::load_arena_bin : can't read " + filename);
+    }
+    checkSize(forest.data_, size, "the file is truncated");
+    forest.setPointers();
+    return forest;
+}
+
+ArenaForest fastforest::load_arena_bin(const void* data, std::size_t size, bool copy) {
+    const char* bytes = static_cast<const char*>(data);
+    checkSize(bytes, size, "the buffer is truncated");
+
+    ArenaForest forest;
+    const bool aligned = reinterpret_cast<std::size_t>(data) % sizeof(int) == 0;
+    if (copy || !aligned) {
+        forest.allocate(size);
+        std::memcpy(forest.data_, data, size);
+    } else {
+        forest.data_ = const_cast<char*>(bytes);
+        forest.size_ = size;
+    }
+    forest.setPointers();
+    return forest;
+}
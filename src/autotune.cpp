@@ -0,0 +1,231 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+#include "common_details.h"
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if __cplusplus >= 201103L
+#include <chrono>
+#endif
+
+using namespace fastforest;
+
+namespace {
+
+    const char* engineNames[] = {"rowbyrow", "blocked", "arena", "grid", "jit"};
+    const int nEngines = 5;
+
+    // Largest lookup table for the grid engine, in bytes
+    const std::size_t maxGridBytes = 64 << 20;
+
+    // Wall-clock time in seconds. Without C++11 this is the processor time, which is the same for one thread.
+    double now() {
+#if __cplusplus >= 201103L
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+        return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+    }
+
+    // Returns the shortest time of several runs, after one run to warm up the caches
+    double timePredict(TunedForest const& forest,
+                       const FeatureType* array,
+                       int nRows,
+                       int rowStride,
+                       TreeEnsembleResponseType* out) {
+        forest.predict(array, nRows, rowStride, out);
+        double best = std::numeric_limits<double>::max();
+        double total = 0.;
+        for (int iRun = 0; iRun < 20 && (iRun < 3 || total < 0.02); ++iRun) {
+            const double start = now();
+            forest.predict(array, nRows, rowStride, out);
+            const double elapsed = now() - start;
+            best = std::min(best, elapsed);
+            total += elapsed;
+        }
+        return best;
+    }
+
+}  // namespace
+
+fastforest::TunedForest::TunedForest(FastForest const& ff, EngineChoice const& choice)
+    : forest_(ff), choice_(choice) {
+    if (choice_.engine == EngineArena) {
+        ArenaForest arena(forest_);
+        arena_.swap(arena);
+    } else if (choice_.engine == EngineGrid && !compile_grid(forest_, grid_, maxGridBytes)) {
+        throw std::runtime_error("Error in fastforest::TunedForest : the forest is too large for the grid engine");
+    } else if (choice_.engine == EngineJit) {
+        JitForest jit(forest_);
+        jit_.swap(jit);
+    }
+}
+
+void fastforest::TunedForest::predict(const FeatureType* array,
+                                      int nRows,
+                                      int rowStride,
+                                      TreeEnsembleResponseType* out) const {
+    const int nOut = forest_.nOutputs();
+    if (choice_.engine == EngineBlocked) {
+        detail::predictBlocked(forest_, array, nRows, rowStride, out, choice_.nThreads, choice_.blockSize);
+    } else if (choice_.engine == EngineArena) {
+        for (int i = 0; i < nRows; ++i) {
+            arena_.evaluate(array + static_cast<std::size_t>(i) * rowStride, out + static_cast<std::size_t>(i) * nOut);
+        }
+    } else if (choice_.engine == EngineGrid) {
+        grid_.predict(array, nRows, rowStride, out);
+    } else if (choice_.engine == EngineJit) {
+        jit_.predict(array, nRows, rowStride, out);
+    } else {
+        for (int i = 0; i < nRows; ++i) {
+            forest_.predict(array + static_cast<std::size_t>(i) * rowStride,
+                            1,
+                            rowStride,
+                            out + static_cast<std::size_t>(i) * nOut);
+        }
+    }
+}
+
+EngineChoice fastforest::autotune(
+    FastForest const& ff, const FeatureType* array, int nRows, int rowStride, int maxThreads) {
+    if (nRows <= 0) {
+        throw std::runtime_error("Error in fastforest::autotune : at least one sample row is needed");
+    }
+
+    const int nOut = ff.nOutputs();
+    std::vector<TreeEnsembleResponseType> reference(static_cast<std::size_t>(nRows) * nOut);
+    std::vector<TreeEnsembleResponseType> out(reference.size());
+    for (int i = 0; i < nRows; ++i) {
+        ff.predict(array + static_cast<std::size_t>(i) * rowStride,
+                   1,
+                   rowStride,
+                   &reference[static_cast<std::size_t>(i) * nOut]);
+    }
+
+    std::vector<EngineChoice> candidates;
+    EngineChoice candidate;
+    candidate.engine = EngineRowByRow;
+    candidates.push_back(candidate);
+    candidate.engine = EngineArena;
+    candidates.push_back(candidate);
+    // only the required size is computed here, the grid itself is compiled when the candidate is timed
+    GridForest grid;
+    std::size_t gridBytes;
+    compile_grid(ff, grid, 0, &gridBytes);
+    if (gridBytes <= maxGridBytes) {
+        candidate.engine = EngineGrid;
+        candidates.push_back(candidate);
+    }
+    if (JitForest(ff).isNative()) {
+        candidate.engine = EngineJit;
+        candidates.push_back(candidate);
+    }
+    candidate.engine = EngineBlocked;
+    const int blockSizes[] = {8, 16, 32, 64, 128, 256};
+    std::vector<int> threadCounts(1, 1);
+    while (threadCounts.back() < maxThreads) {
+        threadCounts.push_back(std::min(2 * threadCounts.back(), maxThreads));
+    }
+    for (std::size_t iThreads = 0; iThreads < threadCounts.size(); ++iThreads) {
+        for (int iBlockSize = 0; iBlockSize < 6; ++iBlockSize) {
+            candidate.blockSize = blockSizes[iBlockSize];
+            candidate.nThreads = threadCounts[iThreads];
+            candidates.push_back(candidate);
+        }
+    }
+
+    EngineChoice best;
+    best.secondsPerRow = std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        const TunedForest forest(ff, candidates[i]);
+        const double seconds = timePredict(forest, array, nRows, rowStride, out.data()) / nRows;
+        // all engines have to give exactly the same results, otherwise something is wrong
+        if (seconds < best.secondsPerRow && out == reference) {
+            best = candidates[i];
+            best.secondsPerRow = seconds;
+        }
+    }
+    best.fingerprint = detail::fingerprint(ff);
+    return best;
+}
+
+void fastforest::EngineChoice::write(std::string const& filename) const {
+    std::ofstream os(filename.c_str());
+    if (!os) {
+        throw std::runtime_error("Error in fastforest::EngineChoice::write : can't open " + filename);
+    }
+    os << "engine " << engineNames[engine] << "\n";
+    os << "block_size " << blockSize << "\n";
+    os << "threads " << nThreads << "\n";
+    os << "seconds_per_row " << secondsPerRow << "\n";
+    os << "fingerprint " << fingerprint << "\n";
+}
+
+bool fastforest::load_engine_choice(std::string const& filename, FastForest const& ff, EngineChoice& choice) {
+    std::ifstream is(filename.c_str());
+    if (!is) {
+        return false;
+    }
+    EngineChoice loaded;
+    std::string key;
+    while (is >> key) {
+        if (key == "engine") {
+            std::string name;
+            is >> name;
+            const char* const* found = std::find(engineNames, engineNames + nEngines, name);
+            if (found == engineNames + nEngines) {
+                throw std::runtime_error("Error in fastforest::load_engine_choice : unknown engine " + name);
+            }
+            loaded.engine = static_cast<EvaluationEngine>(found - engineNames);
+        } else if (key == "block_size") {
+            is >> loaded.blockSize;
+        } else if (key == "threads") {
+            is >> loaded.nThreads;
+        } else if (key == "seconds_per_row") {
+            is >> loaded.secondsPerRow;
+        } else if (key == "fingerprint") {
+            is >> loaded.fingerprint;
+        } else {
+            // skip unknown entries written by newer versions
+            std::string rest;
+            std::getline(is, rest);
+        }
+    }
+    if (loaded.fingerprint != detail::fingerprint(ff)) {
+        return false;
+    }
+    choice = loaded;
+    return true;
+}
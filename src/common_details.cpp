@@ -26,9 +26,45 @@ SOFTWARE.
 
 #include "common_details.h"
 
+#include <algorithm>
+#include <utility>
 #include <vector>
 #include <stdexcept>
 
+#if __cplusplus >= 201103L
+#include <thread>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace {
+
+    // FNV-1a hash over the bytes of an array
+    template <class Type_t>
+    void hashArray(unsigned int& hash, std::vector<Type_t> const& vec) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(vec.data());
+        for (std::size_t i = 0; i < vec.size() * sizeof(Type_t); ++i) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    }
+
+}  // namespace
+
+unsigned int fastforest::detail::fingerprint(FastForest const& ff) {
+    unsigned int hash = 2166136261u;
+    hashArray(hash, ff.rootIndices_);
+    hashArray(hash, ff.cutIndices_);
+    hashArray(hash, ff.cutValues_);
+    hashArray(hash, ff.leftIndices_);
+    hashArray(hash, ff.rightIndices_);
+    hashArray(hash, ff.responses_);
+    hashArray(hash, ff.treeNumbers_);
+    hashArray(hash, ff.baseResponses_);
+    return hash;
+}
+
 void fastforest::detail::correctIndices(std::vector<int>::iterator begin,
                                         std::vector<int>::iterator end,
                                         fastforest::detail::IndexMap const& nodeIndices,
@@ -48,3 +84,105 @@ void fastforest::detail::correctIndices(std::vector<int>::iterator begin,
         }
     }
 }
+
+void fastforest::detail::parallelFor(int n, int nThreads, fastforest::detail::RangeFunction func, void* context) {
+    if (nThreads > n) {
+        nThreads = n;
+    }
+#if __cplusplus >= 201103L
+    if (nThreads > 1) {
+        std::vector<std::thread> threads;
+        threads.reserve(nThreads);
+        int begin = 0;
+        for (int iThread = 0; iThread < nThreads; ++iThread) {
+            int end = begin + n / nThreads + (iThread < n % nThreads ? 1 : 0);
+            threads.emplace_back(func, begin, end, context);
+            begin = end;
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        return;
+    }
+#endif
+    if (n > 0) {
+        func(0, n, context);
+    }
+}
+
+bool fastforest::detail::findFirstLeaves(FastForest const& ff,
+                                         int nLeaves,
+                                         std::vector<int>& firstLeaves,
+                                         int& maxLeavesPerTree) {
+    const int nNodes = ff.cutValues_.size();
+    if (ff.leftIndices_.size() != ff.cutValues_.size() || ff.rightIndices_.size() != ff.cutValues_.size()) {
+        return false;
+    }
+    // the last tree from which each node was reached, and whether it is on the current path from the root
+    std::vector<int> reachedFrom(nNodes, -1);
+    std::vector<char> onPath(nNodes, 0);
+    // the nodes on the current path, with the number of their children that were handled already
+    std::vector<std::pair<int, int> > path;
+
+    firstLeaves.resize(ff.rootIndices_.size());
+    maxLeavesPerTree = 0;
+    for (std::size_t iTree = 0; iTree < ff.rootIndices_.size(); ++iTree) {
+        const int root = ff.rootIndices_[iTree];
+        if (root < 0 || root >= nNodes) {
+            return false;
+        }
+        int minLeaf = nLeaves;
+        int maxLeaf = -1;
+        reachedFrom[root] = iTree;
+        onPath[root] = 1;
+        path.push_back(std::make_pair(root, 0));
+        while (!path.empty()) {
+            const int index = path.back().first;
+            const int iChild = path.back().second++;
+            if (iChild == 2) {
+                onPath[index] = 0;
+                path.pop_back();
+                continue;
+            }
+            const int child = iChild == 0 ? ff.leftIndices_[index] : ff.rightIndices_[index];
+            if (child > 0) {
+                if (child >= nNodes || onPath[child]) {
+                    return false;
+                }
+                if (reachedFrom[child] != static_cast<int>(iTree)) {
+                    reachedFrom[child] = iTree;
+                    onPath[child] = 1;
+                    path.push_back(std::make_pair(child, 0));
+                }
+            } else {
+                if (-child >= nLeaves) {
+                    return false;
+                }
+                minLeaf = std::min(minLeaf, -child);
+                maxLeaf = std::max(maxLeaf, -child);
+            }
+        }
+        firstLeaves[iTree] = minLeaf;
+        maxLeavesPerTree = std::max(maxLeavesPerTree, maxLeaf - minLeaf + 1);
+    }
+    return true;
+}
+
+bool fastforest::detail::bindToCpus(std::vector<int> const& cpus) {
+#ifdef __linux__
+    if (cpus.empty()) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (std::size_t i = 0; i < cpus.size(); ++i) {
+        if (cpus[i] < CPU_SETSIZE) {
+            CPU_SET(cpus[i], &set);
+        }
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
@@ -27,6 +27,9 @@ SOFTWARE.
 #ifndef common_details_h
 #define common_details_h
 
+#include <fastforest.h>
+
+#include <ostream>
 #include <vector>
 #include <map>
 #include <stdexcept>
@@ -41,6 +44,71 @@ namespace fastforest {
                             IndexMap const& nodeIndices,
                             IndexMap const& leafIndices);
 
+        typedef void (*RangeFunction)(int begin, int end, void* context);
+
+        // Calls func(begin, end, context) on consecutive chunks that cover the range [0, n). The chunks are processed
+        // by nThreads parallel threads if the library was compiled with C++11, and sequentially otherwise.
+        void parallelFor(int n, int nThreads, RangeFunction func, void* context);
+
+        // Number of rows that FastForest::predict evaluates together, tree by tree
+        const int defaultBlockSize = 64;
+
+        // The implementation of FastForest::predict with a configurable number of rows per block. If gatherIndices
+        // is given, the nGathered features at these positions are copied from each row into a dense buffer for the
+        // block before the trees are evaluated, and the cut indices of the forest refer to this buffer.
+        void predictBlocked(FastForest const& ff,
+                            const FeatureType* array,
+                            int nRows,
+                            int rowStride,
+                            TreeEnsembleResponseType* out,
+                            int nThreads,
+                            int blockSize,
+                            const int* gatherIndices = NULL,
+                            int nGathered = 0);
+
+        // Hash over all arrays of the forest except the cover statistics, to recognize a forest in files that were
+        // written for it
+        unsigned int fingerprint(FastForest const& ff);
+
+        // Writes the forest in the format of FastForest::write_bin, which fastforest::load_bin reads back
+        void writeBin(std::ostream& os, FastForest const& ff);
+        // Reads a forest written by writeBin, without checking the child indices like fastforest::load_bin does
+        FastForest readBin(std::istream& is);
+
+        // Walks each tree from its root to find the smallest leaf index that can be reached, which is subtracted from
+        // the global leaf indices to count the leaves within the tree, and the largest number of leaves of a tree.
+        // Nodes that are shared within a tree are only visited once. Returns false if an index is out of range, with
+        // nLeaves leaves, or a child points back to one of its ancestors, so this also validates untrusted forests.
+        bool findFirstLeaves(FastForest const& ff, int nLeaves, std::vector<int>& firstLeaves, int& maxLeavesPerTree);
+
+        // Binds the calling thread to the given CPUs, returns false if that's not supported
+        bool bindToCpus(std::vector<int> const& cpus);
+
+        // Walks down a tree starting from the node at `index` and returns the index of the leaf that is reached.
+        // This is the traversal kernel shared by all evaluation functions.
+        inline int evaluateTree(int index,
+                                const FeatureType* array,
+                                const CutIndexType* cutIndices,
+                                const FeatureType* cutValues,
+                                const int* leftIndices,
+                                const int* rightIndices) {
+            do {
+                int r = rightIndices[index];
+                int l = leftIndices[index];
+                index = array[cutIndices[index]] < cutValues[index] ? l : r;
+            } while (index > 0);
+            return -index;
+        }
+
+        inline int evaluateTree(FastForest const& ff, int index, const FeatureType* array) {
+            return evaluateTree(index,
+                                array,
+                                ff.cutIndices_.data(),
+                                ff.cutValues_.data(),
+                                ff.leftIndices_.data(),
+                                ff.rightIndices_.data());
+        }
+
     }  // namespace detail
 
 }  // namespace fastforest
@@ -0,0 +1,96 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+#include "common_details.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace fastforest;
+
+namespace {
+
+    // Sorts by decreasing frequency, and by the original position for features that are read equally often
+    bool moreFrequent(std::pair<std::size_t, int> const& a, std::pair<std::size_t, int> const& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    }
+
+}  // namespace
+
+fastforest::CompactForest::CompactForest(FastForest const& ff, ForestProfile const* profile) : forest_(ff) {
+    int nFeatures = 0;
+    for (std::size_t i = 0; i < ff.cutIndices_.size(); ++i) {
+        nFeatures = std::max(nFeatures, static_cast<int>(ff.cutIndices_[i]) + 1);
+    }
+    if (profile && profile->featureAccesses.size() < static_cast<std::size_t>(nFeatures)) {
+        throw std::runtime_error("Error in fastforest::CompactForest : the profile was recorded with another forest");
+    }
+
+    std::vector<std::size_t> nNodes(nFeatures);
+    for (std::size_t i = 0; i < ff.cutIndices_.size(); ++i) {
+        ++nNodes[ff.cutIndices_[i]];
+    }
+
+    // (frequency, original index) of each used feature, also of the ones that were never read in the profile
+    std::vector<std::pair<std::size_t, int> > frequencies;
+    for (int i = 0; i < nFeatures; ++i) {
+        if (nNodes[i] > 0) {
+            frequencies.push_back(std::make_pair(profile ? profile->featureAccesses[i] : nNodes[i], i));
+        }
+    }
+    std::sort(frequencies.begin(), frequencies.end(), moreFrequent);
+
+    std::vector<int> newIndices(nFeatures, -1);
+    for (std::size_t i = 0; i < frequencies.size(); ++i) {
+        newIndices[frequencies[i].second] = i;
+        usedFeatures_.push_back(frequencies[i].second);
+    }
+    for (std::size_t i = 0; i < forest_.cutIndices_.size(); ++i) {
+        forest_.cutIndices_[i] = newIndices[forest_.cutIndices_[i]];
+    }
+}
+
+void fastforest::CompactForest::predict(
+    const FeatureType* array, int nRows, int rowStride, TreeEnsembleResponseType* out, int nThreads) const {
+    detail::predictBlocked(forest_,
+                           array,
+                           nRows,
+                           rowStride,
+                           out,
+                           nThreads,
+                           detail::defaultBlockSize,
+                           usedFeatures_.data(),
+                           usedFeatures_.size());
+}
+
+void fastforest::CompactForest::gather(const FeatureType* array, FeatureType* compact) const {
+    for (std::size_t i = 0; i < usedFeatures_.size(); ++i) {
+        compact[i] = array[usedFeatures_[i]];
+    }
+}
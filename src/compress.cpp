@@ -0,0 +1,209 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+
+#include <cstring>
+#include <map>
+#include <vector>
+
+using namespace fastforest;
+
+namespace {
+
+    struct NodeKey {
+        CutIndexType cutIndex;
+        unsigned int cutValueBits;
+        int left;
+        int right;
+
+        bool operator<(NodeKey const& other) const {
+            if (cutIndex != other.cutIndex)
+                return cutIndex < other.cutIndex;
+            if (cutValueBits != other.cutValueBits)
+                return cutValueBits < other.cutValueBits;
+            if (left != other.left)
+                return left < other.left;
+            return right < other.right;
+        }
+    };
+
+    template <class Float_t>
+    unsigned int floatBits(Float_t x) {
+        unsigned int bits = 0;
+        std::memcpy(&bits, &x, sizeof(x) < sizeof(bits) ? sizeof(x) : sizeof(bits));
+        return bits;
+    }
+
+    // Builds the compressed forest in two steps: first, every subtree is mapped to a canonical id, such that
+    // identical subtrees get the same id. Leaves get negative ids and nodes non-negative ones. Then, the canonical
+    // subtrees are written out again, each of them only once.
+    class Compressor {
+      public:
+        explicit Compressor(FastForest const& ff) : ff_(ff), nodeCanon_(ff.cutValues_.size(), -1) {}
+
+        int canonicalNode(int index) {
+            if (nodeCanon_[index] >= 0) {
+                return nodeCanon_[index];
+            }
+            const int left = canonicalChild(ff_.leftIndices_[index]);
+            const int right = canonicalChild(ff_.rightIndices_[index]);
+            int canon;
+            if (left == right) {
+                // the split doesn't matter, as both children are identical
+                canon = left;
+            } else {
+                NodeKey key;
+                key.cutIndex = ff_.cutIndices_[index];
+                key.cutValueBits = floatBits(ff_.cutValues_[index]);
+                key.left = left;
+                key.right = right;
+                std::map<NodeKey, int>::iterator found = nodeIds_.find(key);
+                if (found == nodeIds_.end()) {
+                    found = nodeIds_.insert(std::make_pair(key, static_cast<int>(nodes_.size()))).first;
+                    nodes_.push_back(key);
+                    nodeCutValues_.push_back(ff_.cutValues_[index]);
+                }
+                canon = found->second;
+            }
+            // the memoization can't store negative leaf ids, they are cheap to look up again anyway
+            if (canon >= 0) {
+                nodeCanon_[index] = canon;
+            }
+            return canon;
+        }
+
+        // Appends the canonical subtree to the output forest if it is not already there, and returns its index
+        // encoded like the child indices (leaves as non-positive numbers).
+        int emit(FastForest& out, int canon, bool isRoot) {
+            if (canon < 0) {
+                const int leafId = -canon - 1;
+                if (emittedLeaves_[leafId] < 0) {
+                    emittedLeaves_[leafId] = out.responses_.size();
+                    out.responses_.push_back(leaves_[leafId]);
+                }
+                return -emittedLeaves_[leafId];
+            }
+            // Node zero can't be referenced as a child, because a child index of zero means the first leaf.
+            if (emittedNodes_[canon] > 0 || (isRoot && emittedNodes_[canon] == 0)) {
+                return emittedNodes_[canon];
+            }
+            const int index = out.cutValues_.size();
+            emittedNodes_[canon] = index;
+            out.cutIndices_.push_back(nodes_[canon].cutIndex);
+            out.cutValues_.push_back(nodeCutValues_[canon]);
+            out.leftIndices_.push_back(0);
+            out.rightIndices_.push_back(0);
+            const int left = emit(out, nodes_[canon].left, false);
+            const int right = emit(out, nodes_[canon].right, false);
+            out.leftIndices_[index] = left;
+            out.rightIndices_[index] = right;
+            return index;
+        }
+
+        void prepareEmission() {
+            emittedNodes_.assign(nodes_.size(), -1);
+            emittedLeaves_.assign(leaves_.size(), -1);
+        }
+
+        TreeResponseType leafValue(int canon) const { return leaves_[-canon - 1]; }
+
+      private:
+        int canonicalChild(int child) {
+            if (child > 0) {
+                return canonicalNode(child);
+            }
+            const TreeResponseType value = ff_.responses_[-child];
+            const unsigned int bits = floatBits(value);
+            std::map<unsigned int, int>::iterator found = leafIds_.find(bits);
+            if (found == leafIds_.end()) {
+                found = leafIds_.insert(std::make_pair(bits, static_cast<int>(leaves_.size()))).first;
+                leaves_.push_back(value);
+            }
+            return -found->second - 1;
+        }
+
+        FastForest const& ff_;
+        std::vector<int> nodeCanon_;
+
+        std::map<NodeKey, int> nodeIds_;
+        std::vector<NodeKey> nodes_;
+        std::vector<FeatureType> nodeCutValues_;
+
+        std::map<unsigned int, int> leafIds_;
+        std::vector<TreeResponseType> leaves_;
+
+        std::vector<int> emittedNodes_;
+        std::vector<int> emittedLeaves_;
+    };
+
+    std::size_t sizeInBytes(FastForest const& ff) {
+        return ff.rootIndices_.size() * sizeof(int) + ff.cutIndices_.size() * sizeof(CutIndexType) +
+               ff.cutValues_.size() * sizeof(FeatureType) + ff.leftIndices_.size() * sizeof(int) +
+               ff.rightIndices_.size() * sizeof(int) + ff.responses_.size() * sizeof(TreeResponseType) +
+               ff.treeNumbers_.size() * sizeof(int) + ff.baseResponses_.size() * sizeof(TreeEnsembleResponseType) +
+               ff.nodeCovers_.size() * sizeof(TreeResponseType) + ff.leafCovers_.size() * sizeof(TreeResponseType);
+    }
+
+}  // namespace
+
+FastForest fastforest::compress(FastForest const& ff, CompressionReport* report) {
+    Compressor compressor(ff);
+
+    std::vector<int> rootCanons(ff.rootIndices_.size());
+    for (std::size_t iTree = 0; iTree < ff.rootIndices_.size(); ++iTree) {
+        rootCanons[iTree] = compressor.canonicalNode(ff.rootIndices_[iTree]);
+    }
+
+    compressor.prepareEmission();
+
+    FastForest out;
+    out.baseResponses_ = ff.baseResponses_;
+    for (std::size_t iTree = 0; iTree < ff.rootIndices_.size(); ++iTree) {
+        if (rootCanons[iTree] < 0) {
+            // the whole tree collapsed to a single leaf
+            out.baseResponses_[ff.treeNumbers_[iTree] % out.baseResponses_.size()] +=
+                compressor.leafValue(rootCanons[iTree]);
+            continue;
+        }
+        out.rootIndices_.push_back(compressor.emit(out, rootCanons[iTree], true));
+        out.treeNumbers_.push_back(ff.treeNumbers_[iTree]);
+    }
+
+    if (report) {
+        report->nTreesBefore = ff.rootIndices_.size();
+        report->nTreesAfter = out.rootIndices_.size();
+        report->nNodesBefore = ff.cutValues_.size();
+        report->nNodesAfter = out.cutValues_.size();
+        report->nLeavesBefore = ff.responses_.size();
+        report->nLeavesAfter = out.responses_.size();
+        report->bytesBefore = sizeInBytes(ff);
+        report->bytesAfter = sizeInBytes(out);
+    }
+
+    out.prepareLeafIndices();
+    return out;
+}
@@ -0,0 +1,470 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+#include "common_details.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace fastforest;
+
+// The compressed binary format stores each array of the forest as a separate stream. First, the array is transformed
+// to make it more compressible: integer arrays are mapped to small numbers and bit-packed, and the bytes of float
+// arrays are shuffled such that all first bytes come first, then all second bytes, and so on. Then, each stream is
+// compressed with a simple LZ77 codec, where a block is a sequence of literal runs and back references.
+
+namespace {
+
+    const char magic[4] = {'F', 'F', 'Z', '1'};
+
+    const char* const corrupted = "Error in fastforest::load_compressed_bin : the data is corrupted";
+
+    // Back references are searched with a hash table of the last position of each four-byte sequence
+    const int minMatch = 4;
+    // Longer matches are split, which limits how much output the decoder can produce per byte of compressed data.
+    // Each match takes at least three bytes, so a stream of n bytes decompresses to less than n * maxMatch bytes.
+    const int maxMatch = 1 << 16;
+    const int hashBits = 16;
+
+    typedef std::vector<unsigned char> Bytes;
+
+    void writeVarint(Bytes& out, unsigned int value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+    // Reads the variable-length integers and checks that they don't run past the end
+    class VarintReader {
+      public:
+        VarintReader(const unsigned char* pos, const unsigned char* end) : pos_(pos), end_(end) {}
+
+        unsigned int read() {
+            // most values are small, like the deltas of regular index arrays
+            if (pos_ != end_ && *pos_ < 0x80) {
+                return *pos_++;
+            }
+            unsigned int value = 0;
+            for (int shift = 0; shift < 35; shift += 7) {
+                if (pos_ == end_) {
+                    throw std::runtime_error(corrupted);
+                }
+                const unsigned char byte = *pos_++;
+                value |= static_cast<unsigned int>(byte & 0x7F) << shift;
+                if (byte < 0x80) {
+                    return value;
+                }
+            }
+            throw std::runtime_error(corrupted);
+        }
+
+        const unsigned char* pos() const { return pos_; }
+        void skip(std::size_t n) { pos_ += n; }
+        std::size_t remaining() const { return end_ - pos_; }
+
+      private:
+        const unsigned char* pos_;
+        const unsigned char* end_;
+    };
+
+    inline unsigned int zigzag(int value) {
+        return (static_cast<unsigned int>(value) << 1) ^ static_cast<unsigned int>(value >> 31);
+    }
+
+    inline int unzigzag(unsigned int value) { return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1); }
+
+    // Integer arrays are first mapped to small unsigned values, and then bit-packed in blocks of packBlockSize values
+    // with the smallest bit width that fits all values of the block. Each block starts with a byte for the width.
+    // The packed stream ends with eight padding bytes, such that the decoder can always load eight bytes at once.
+    const int packBlockSize = 128;
+    const int packPadding = 8;
+
+    Bytes packValues(std::vector<unsigned int> const& values) {
+        Bytes out;
+        for (std::size_t begin = 0; begin < values.size(); begin += packBlockSize) {
+            const std::size_t end = std::min(begin + packBlockSize, values.size());
+            unsigned int maxValue = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                maxValue |= values[i];
+            }
+            int width = 0;
+            while (width < 32 && (maxValue >> width) != 0) {
+                ++width;
+            }
+            out.push_back(static_cast<unsigned char>(width));
+            const std::size_t first = out.size();
+            out.resize(first + ((end - begin) * width + 7) / 8, 0);
+            std::size_t bitPos = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                for (int bit = 0; bit < width; ++bit, ++bitPos) {
+                    out[first + bitPos / 8] |= static_cast<unsigned char>(((values[i] >> bit) & 1) << (bitPos % 8));
+                }
+            }
+        }
+        out.resize(out.size() + packPadding, 0);
+        return out;
+    }
+
+    // Checks that a packed stream can hold size values, with at least one byte for the width of each block, before
+    // the output array is allocated
+    void checkPackedSize(Bytes const& in, int size) {
+        const std::size_t nBlocks = (static_cast<std::size_t>(size) + packBlockSize - 1) / packBlockSize;
+        if (size < 0 || in.size() < packPadding || nBlocks > in.size() - packPadding) {
+            throw std::runtime_error(corrupted);
+        }
+    }
+
+    // Unpacks size values and passes them with their index to the sink, which writes them to the final array
+    template <class Sink_t>
+    void unpackValues(Bytes const& in, int size, Sink_t& sink) {
+        std::size_t pos = 0;
+        for (int begin = 0; begin < size; begin += packBlockSize) {
+            const int end = std::min(begin + packBlockSize, size);
+            const int width = pos < in.size() ? in[pos] : 64;
+            const std::size_t nBytes = (static_cast<std::size_t>(end - begin) * width + 7) / 8;
+            if (width > 32 || pos + 1 + nBytes + packPadding > in.size()) {
+                throw std::runtime_error(corrupted);
+            }
+            const unsigned char* data = &in[pos + 1];
+            const unsigned int mask = width == 32 ? ~0u : (1u << width) - 1;
+            std::size_t bitPos = 0;
+            for (int i = begin; i < end; ++i) {
+                // a value spans at most five bytes, because the width is at most 32 and the shift at most 7
+                const unsigned char* bytes = data + bitPos / 8;
+                const unsigned int shift = bitPos % 8;
+                unsigned int word = bytes[0] | bytes[1] << 8 | bytes[2] << 16;
+                word = (word | static_cast<unsigned int>(bytes[3]) << 24) >> shift;
+                if (shift != 0) {
+                    word |= static_cast<unsigned int>(bytes[4]) << (32 - shift);
+                }
+                sink(i, word & mask);
+                bitPos += width;
+            }
+            pos += 1 + nBytes;
+        }
+    }
+
+    // Sorted or regular arrays like the root indices are stored as differences to the previous value
+    template <class Int_t>
+    Bytes encodeDeltas(std::vector<Int_t> const& values) {
+        std::vector<unsigned int> mapped(values.size());
+        int previous = 0;
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            const int value = static_cast<int>(values[i]);
+            mapped[i] = zigzag(value - previous);
+            previous = value;
+        }
+        return packValues(mapped);
+    }
+
+    template <class Int_t>
+    struct DeltaSink {
+        explicit DeltaSink(Int_t* out) : out_(out), previous_(0) {}
+        void operator()(int i, unsigned int value) {
+            previous_ += unzigzag(value);
+            out_[i] = static_cast<Int_t>(previous_);
+        }
+        Int_t* out_;
+        int previous_;
+    };
+
+    template <class Int_t>
+    void decodeDeltas(Bytes const& in, std::vector<Int_t>& values, int size) {
+        checkPackedSize(in, size);
+        values.resize(size);
+        DeltaSink<Int_t> sink(values.data());
+        unpackValues(in, size, sink);
+    }
+
+    // The children of a node are usually stored shortly after it, and the leaf indices grow about as fast as the node
+    // indices. So the child indices are stored relative to the index of the node, with the lowest bit telling
+    // whether the child is a leaf.
+    Bytes encodeChildren(std::vector<int> const& children) {
+        std::vector<unsigned int> mapped(children.size());
+        for (std::size_t i = 0; i < children.size(); ++i) {
+            const int index = static_cast<int>(i);
+            mapped[i] = children[i] > 0 ? zigzag(children[i] - index) << 1 : zigzag(-children[i] - index) << 1 | 1;
+        }
+        return packValues(mapped);
+    }
+
+    struct ChildSink {
+        explicit ChildSink(int* out) : out_(out) {}
+        void operator()(int i, unsigned int value) {
+            const int distance = unzigzag(value >> 1);
+            out_[i] = value & 1 ? -(i + distance) : i + distance;
+        }
+        int* out_;
+    };
+
+    void decodeChildren(Bytes const& in, std::vector<int>& children, int size) {
+        checkPackedSize(in, size);
+        children.resize(size);
+        ChildSink sink(children.data());
+        unpackValues(in, size, sink);
+    }
+
+    template <class Float_t>
+    Bytes shuffleBytes(std::vector<Float_t> const& values) {
+        const std::size_t n = values.size();
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values.data());
+        Bytes out(n * sizeof(Float_t));
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t b = 0; b < sizeof(Float_t); ++b) {
+                out[b * n + i] = bytes[i * sizeof(Float_t) + b];
+            }
+        }
+        return out;
+    }
+
+    template <class Float_t>
+    void unshuffleBytes(Bytes const& in, std::vector<Float_t>& values, int size) {
+        if (in.size() != size * sizeof(Float_t)) {
+            throw std::runtime_error(corrupted);
+        }
+        values.resize(size);
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(values.data());
+        for (int i = 0; i < size; ++i) {
+            for (std::size_t b = 0; b < sizeof(Float_t); ++b) {
+                bytes[i * sizeof(Float_t) + b] = in[b * size + i];
+            }
+        }
+    }
+
+    inline unsigned int hash4(const unsigned char* p) {
+        unsigned int value;
+        std::memcpy(&value, p, 4);
+        return (value * 2654435761u) >> (32 - hashBits);
+    }
+
+    // Appends the sequences (literal length, literals, match length - minMatch, offset) of the input to out. The last
+    // sequence has only literals.
+    void lzCompress(Bytes const& in, Bytes& out) {
+        const std::size_t n = in.size();
+        std::vector<int> table(1 << hashBits, -1);
+        std::size_t literalStart = 0;
+        std::size_t pos = 0;
+        while (pos + minMatch <= n) {
+            const unsigned int h = hash4(&in[pos]);
+            const int candidate = table[h];
+            table[h] = pos;
+            if (candidate < 0 || std::memcmp(&in[candidate], &in[pos], minMatch) != 0) {
+                ++pos;
+                continue;
+            }
+            std::size_t length = minMatch;
+            while (pos + length < n && length < maxMatch && in[candidate + length] == in[pos + length]) {
+                ++length;
+            }
+            writeVarint(out, pos - literalStart);
+            out.insert(out.end(), in.begin() + literalStart, in.begin() + pos);
+            writeVarint(out, length - minMatch);
+            writeVarint(out, pos - candidate);
+            pos += length;
+            literalStart = pos;
+        }
+        writeVarint(out, n - literalStart);
+        out.insert(out.end(), in.begin() + literalStart, in.end());
+    }
+
+    void lzDecompress(const unsigned char* data, std::size_t size, Bytes& out, std::size_t outSize) {
+        out.resize(outSize);
+        unsigned char* dst = out.data();
+        unsigned char* const dstEnd = dst + outSize;
+        VarintReader reader(data, data + size);
+        for (;;) {
+            const std::size_t nLiterals = reader.read();
+            if (nLiterals > reader.remaining() || nLiterals > static_cast<std::size_t>(dstEnd - dst)) {
+                throw std::runtime_error(corrupted);
+            }
+            if (nLiterals > 0) {
+                std::memcpy(dst, reader.pos(), nLiterals);
+            }
+            dst += nLiterals;
+            reader.skip(nLiterals);
+            if (dst == dstEnd) {
+                return;
+            }
+            const std::size_t length = reader.read() + static_cast<std::size_t>(minMatch);
+            const std::size_t offset = reader.read();
+            if (offset == 0 || offset > static_cast<std::size_t>(dst - out.data()) || length > maxMatch ||
+                length > static_cast<std::size_t>(dstEnd - dst)) {
+                throw std::runtime_error(corrupted);
+            }
+            // If the match overlaps with its own output, the last offset bytes are repeated. They are copied in
+            // non-overlapping pieces, which double in size as the repeated output grows.
+            const unsigned char* src = dst - offset;
+            std::size_t remaining = length;
+            std::size_t piece = offset;
+            while (remaining > 0) {
+                const std::size_t n = std::min(piece, remaining);
+                std::memcpy(dst, src, n);
+                dst += n;
+                remaining -= n;
+                piece += n;
+            }
+        }
+    }
+
+    // Writes a stream as its uncompressed size, its compressed size and the compressed data
+    void writeStream(std::ostream& os, Bytes const& raw) {
+        Bytes compressed;
+        lzCompress(raw, compressed);
+        Bytes header;
+        writeVarint(header, raw.size());
+        writeVarint(header, compressed.size());
+        os.write(reinterpret_cast<const char*>(header.data()), header.size());
+        os.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+    }
+
+    void readStream(VarintReader& reader, Bytes& raw) {
+        const std::size_t rawSize = reader.read();
+        const std::size_t compressedSize = reader.read();
+        if (compressedSize > reader.remaining()) {
+            throw std::runtime_error("Error in fastforest::load_compressed_bin : unexpected end of the data");
+        }
+        // check the size before allocating the output, which would fail for sizes that can't be right
+        if (rawSize / maxMatch > compressedSize) {
+            throw std::runtime_error(corrupted);
+        }
+        lzDecompress(reader.pos(), compressedSize, raw, rawSize);
+        reader.skip(compressedSize);
+    }
+
+    // Checks that all indices are within the arrays and that no child points back to one of its ancestors, such that
+    // evaluating the loaded forest can neither read past the arrays nor loop forever
+    bool hasValidIndices(FastForest const& ff) {
+        bool valid = !ff.baseResponses_.empty();
+        for (std::size_t i = 0; valid && i < ff.treeNumbers_.size(); ++i) {
+            valid = ff.treeNumbers_[i] >= 0;
+        }
+        std::vector<int> firstLeaves;
+        int maxLeavesPerTree;
+        return valid && detail::findFirstLeaves(ff, ff.responses_.size(), firstLeaves, maxLeavesPerTree);
+    }
+
+}  // namespace
+
+void fastforest::FastForest::write_compressed_bin(std::string const& filename) const {
+    std::ofstream os(filename.c_str(), std::ios::binary);
+    if (!os) {
+        throw std::runtime_error("Error in FastForest::write_compressed_bin : can't open " + filename);
+    }
+    os.write(magic, sizeof(magic));
+
+    const bool hasCovers = !nodeCovers_.empty();
+    Bytes header;
+    writeVarint(header, rootIndices_.size());
+    writeVarint(header, cutValues_.size());
+    writeVarint(header, responses_.size());
+    writeVarint(header, baseResponses_.size());
+    writeVarint(header, hasCovers);
+    os.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+    writeStream(os, encodeDeltas(rootIndices_));
+    writeStream(os, encodeDeltas(cutIndices_));
+    writeStream(os, shuffleBytes(cutValues_));
+    writeStream(os, encodeChildren(leftIndices_));
+    writeStream(os, encodeChildren(rightIndices_));
+    writeStream(os, shuffleBytes(responses_));
+    writeStream(os, encodeDeltas(treeNumbers_));
+    writeStream(os, shuffleBytes(baseResponses_));
+    if (hasCovers) {
+        writeStream(os, shuffleBytes(nodeCovers_));
+        writeStream(os, shuffleBytes(leafCovers_));
+    }
+}
+
+FastForest fastforest::load_compressed_bin(std::string const& filename) {
+    std::ifstream is(filename.c_str(), std::ios::binary);
+    if (!is) {
+        throw std::runtime_error("Error in fastforest::load_compressed_bin : can't open " + filename);
+    }
+    is.seekg(0, std::ios::end);
+    const std::streamoff end = is.tellg();
+    is.seekg(0, std::ios::beg);
+    if (end < 0 || !is) {
+        throw std::runtime_error("Error in fastforest::load_compressed_bin : can't determine the size of " + filename);
+    }
+    std::vector<char> content(static_cast<std::size_t>(end));
+    if (!is.read(content.data(), content.size())) {
+        throw std::runtime_error("Error in fastforest::load_compressed_bin : can't read " + filename);
+    }
+    return load_compressed_bin(content.data(), content.size());
+}
+
+FastForest fastforest::load_compressed_bin(const void* data, std::size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    if (size < sizeof(magic) || std::memcmp(bytes, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Error in fastforest::load_compressed_bin : not a compressed FastForest model");
+    }
+    VarintReader reader(bytes + sizeof(magic), bytes + size);
+    const int nRootNodes = reader.read();
+    const int nNodes = reader.read();
+    const int nLeaves = reader.read();
+    const int nBaseResponses = reader.read();
+    const bool hasCovers = reader.read() != 0;
+    if (nRootNodes < 0 || nNodes < 0 || nLeaves < 0 || nBaseResponses < 0) {
+        throw std::runtime_error(corrupted);
+    }
+
+    FastForest ff;
+    Bytes raw;
+    readStream(reader, raw);
+    decodeDeltas(raw, ff.rootIndices_, nRootNodes);
+    readStream(reader, raw);
+    decodeDeltas(raw, ff.cutIndices_, nNodes);
+    readStream(reader, raw);
+    unshuffleBytes(raw, ff.cutValues_, nNodes);
+    readStream(reader, raw);
+    decodeChildren(raw, ff.leftIndices_, nNodes);
+    readStream(reader, raw);
+    decodeChildren(raw, ff.rightIndices_, nNodes);
+    readStream(reader, raw);
+    unshuffleBytes(raw, ff.responses_, nLeaves);
+    readStream(reader, raw);
+    decodeDeltas(raw, ff.treeNumbers_, nRootNodes);
+    readStream(reader, raw);
+    unshuffleBytes(raw, ff.baseResponses_, nBaseResponses);
+    if (hasCovers) {
+        readStream(reader, raw);
+        unshuffleBytes(raw, ff.nodeCovers_, nNodes);
+        readStream(reader, raw);
+        unshuffleBytes(raw, ff.leafCovers_, nLeaves);
+    }
+    if (!hasValidIndices(ff)) {
+        throw std::runtime_error(corrupted);
+    }
+    ff.prepareLeafIndices();
+    return ff;
+}
@@ -25,15 +25,31 @@ SOFTWARE.
 */
 
 #include <fastforest.h>
+#include "common_details.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <fstream>
+#include <limits>
 #include <string>
 #include <sstream>
 #include <stdexcept>
 
 using namespace fastforest;
 
+void fastforest::details::softmaxTransformInplace(double* out, int nOut) {
+    const double wmax = *std::max_element(out, out + nOut);
+    double norm = 0.;
+    for (int i = 0; i < nOut; ++i) {
+        out[i] = std::exp(out[i] - wmax);
+        norm += out[i];
+    }
+    for (int i = 0; i < nOut; ++i) {
+        out[i] /= norm;
+    }
+}
+
 void fastforest::details::softmaxTransformInplace(TreeEnsembleResponseType* out, int nOut) {
     // Do softmax transformation inplace, mimicking exactly the Softmax function
     // in the src/common/math.h source file of xgboost.
@@ -81,13 +97,7 @@ void fastforest::FastForest::evaluate(const FeatureType* array, TreeEnsembleResp
     int iRootIndex = 0;
     for (std::vector<int>::const_iterator indexIter = rootIndices_.begin(); indexIter != rootIndices_.end();
          ++indexIter) {
-        int index = *indexIter;
-        do {
-            int r = rightIndices_[index];
-            int l = leftIndices_[index];
-            index = array[cutIndices_[index]] < cutValues_[index] ? l : r;
-        } while (index > 0);
-        out[treeNumbers_[iRootIndex] % nOut] += responses_[-index];
+        out[treeNumbers_[iRootIndex] % nOut] += responses_[detail::evaluateTree(*this, *indexIter, array)];
         ++iRootIndex;
     }
 }
@@ -97,79 +107,558 @@ TreeEnsembleResponseType fastforest::FastForest::evaluateBinary(const FeatureTyp
 
     for (std::vector<int>::const_iterator indexIter = rootIndices_.begin(); indexIter != rootIndices_.end();
          ++indexIter) {
-        int index = *indexIter;
-        do {
-            int r = rightIndices_[index];
-            int l = leftIndices_[index];
-            index = array[cutIndices_[index]] < cutValues_[index] ? l : r;
-        } while (index > 0);
-        out += responses_[-index];
+        out += responses_[detail::evaluateTree(*this, *indexIter, array)];
     }
 
     return out;
 }
 
+namespace {
+
+    // The rows of an evaluation and how they are split into blocks
+    struct BlockedRows {
+        FastForest const* ff;
+        const FeatureType* array;
+        int rowStride;
+        int blockSize;
+        // optional positions of the features that are gathered from each row, see detail::predictBlocked
+        const int* gatherIndices;
+        int nGathered;
+    };
+
+    // Evaluates the rows in [begin, end) in blocks tree by tree, such that the nodes of each tree are reused from the
+    // cache for all rows in a block. The leaves that the rows of a block reach in a tree are passed to the sink
+    // together, which keeps the traversal loop free from the bookkeeping of the sink.
+    template <class Sink>
+    void evaluateBlocks(BlockedRows const& input, int begin, int end, Sink sink) {
+        FastForest const& ff = *input.ff;
+
+        const int blockSize = input.blockSize;
+        const int nTrees = ff.rootIndices_.size();
+        const CutIndexType* cutIndices = ff.cutIndices_.data();
+        const FeatureType* cutValues = ff.cutValues_.data();
+        const int* leftIndices = ff.leftIndices_.data();
+        const int* rightIndices = ff.rightIndices_.data();
+
+        std::vector<FeatureType> gathered(input.gatherIndices ? blockSize * input.nGathered : 0);
+        std::vector<int> leaves(blockSize);
+        const int rowStride = input.gatherIndices ? input.nGathered : input.rowStride;
+
+        for (int blockBegin = begin; blockBegin < end; blockBegin += blockSize) {
+            const int blockEnd = std::min(blockBegin + blockSize, end);
+            const FeatureType* rows = input.array + static_cast<std::size_t>(blockBegin) * input.rowStride;
+            if (input.gatherIndices) {
+                for (int iRow = 0; iRow < blockEnd - blockBegin; ++iRow) {
+                    const FeatureType* row = rows + static_cast<std::size_t>(iRow) * input.rowStride;
+                    for (int i = 0; i < input.nGathered; ++i) {
+                        gathered[iRow * input.nGathered + i] = row[input.gatherIndices[i]];
+                    }
+                }
+                rows = gathered.data();
+            }
+            sink.beginBlock(blockBegin, blockEnd - blockBegin);
+            // The trees are still visited in the same order for each row, so the results are identical to the
+            // evaluation of the rows one by one.
+            for (int iTree = 0; iTree < nTrees; ++iTree) {
+                const int root = ff.rootIndices_[iTree];
+                const FeatureType* row = rows;
+                for (int iRow = 0; iRow < blockEnd - blockBegin; ++iRow) {
+                    leaves[iRow] = detail::evaluateTree(root, row, cutIndices, cutValues, leftIndices, rightIndices);
+                    row += rowStride;
+                }
+                sink.addTree(iTree, leaves.data(), blockEnd - blockBegin);
+            }
+            sink.endBlock(blockEnd - blockBegin);
+        }
+    }
+
+    // Sums up the responses of the reached leaves. The scores are accumulated in the output type, which can have a
+    // higher precision than the tree responses.
+    template <class Out_t>
+    class ScoreSink {
+      public:
+        ScoreSink(FastForest const& ff, Out_t* out)
+            : ff_(ff), nOut_(ff.baseResponses_.size()), out_(out), blockOut_(NULL) {}
+
+        void beginBlock(int blockBegin, int nRows) {
+            blockOut_ = out_ + static_cast<std::size_t>(blockBegin) * nOut_;
+            for (int iRow = 0; iRow < nRows; ++iRow) {
+                for (int i = 0; i < nOut_; ++i) {
+                    blockOut_[iRow * nOut_ + i] = ff_.baseResponses_[i];
+                }
+            }
+        }
+        void addTree(int iTree, const int* leaves, int nRows) {
+            Out_t* treeOut = blockOut_ + (nOut_ == 1 ? 0 : ff_.treeNumbers_[iTree] % nOut_);
+            const TreeResponseType* responses = ff_.responses_.data();
+            for (int iRow = 0; iRow < nRows; ++iRow) {
+                treeOut[iRow * nOut_] += responses[leaves[iRow]];
+            }
+        }
+        void endBlock(int /*nRows*/) {}
+
+      private:
+        FastForest const& ff_;
+        int nOut_;
+        Out_t* out_;
+        Out_t* blockOut_;
+    };
+
+    // Writes the index of the reached leaf counted within its tree
+    template <class LeafIndex_t>
+    class LeafSink {
+      public:
+        LeafSink(FastForest const& ff, const int* firstLeaves, LeafIndex_t* out, int blockSize)
+            : nTrees_(ff.rootIndices_.size()),
+              blockSize_(blockSize),
+              firstLeaves_(firstLeaves),
+              out_(out),
+              blockOut_(NULL),
+              blockLeaves_(static_cast<std::size_t>(nTrees_) * blockSize) {}
+
+        void beginBlock(int blockBegin, int /*nRows*/) {
+            blockOut_ = out_ + static_cast<std::size_t>(blockBegin) * nTrees_;
+        }
+        void addTree(int iTree, const int* leaves, int nRows) {
+            LeafIndex_t* treeLeaves = &blockLeaves_[static_cast<std::size_t>(iTree) * blockSize_];
+            const int firstLeaf = firstLeaves_[iTree];
+            for (int iRow = 0; iRow < nRows; ++iRow) {
+                treeLeaves[iRow] = static_cast<LeafIndex_t>(leaves[iRow] - firstLeaf);
+            }
+        }
+        // the leaves are collected tree by tree, and written to the output row by row
+        void endBlock(int nRows) {
+            for (int iRow = 0; iRow < nRows; ++iRow) {
+                LeafIndex_t* rowOut = blockOut_ + static_cast<std::size_t>(iRow) * nTrees_;
+                for (int iTree = 0; iTree < nTrees_; ++iTree) {
+                    rowOut[iTree] = blockLeaves_[static_cast<std::size_t>(iTree) * blockSize_ + iRow];
+                }
+            }
+        }
+
+      private:
+        int nTrees_;
+        int blockSize_;
+        const int* firstLeaves_;
+        LeafIndex_t* out_;
+        LeafIndex_t* blockOut_;
+        std::vector<LeafIndex_t> blockLeaves_;
+    };
+
+    template <class Out_t>
+    struct PredictContext {
+        BlockedRows rows;
+        Out_t* out;
+    };
+
+    template <class Out_t>
+    void predictRange(int begin, int end, void* context) {
+        PredictContext<Out_t> const& ctx = *static_cast<PredictContext<Out_t>*>(context);
+        evaluateBlocks(ctx.rows, begin, end, ScoreSink<Out_t>(*ctx.rows.ff, ctx.out));
+    }
+
+    template <class LeafIndex_t>
+    struct LeavesContext {
+        BlockedRows rows;
+        const int* firstLeaves;
+        LeafIndex_t* out;
+    };
+
+    template <class LeafIndex_t>
+    void predictLeavesRange(int begin, int end, void* context) {
+        LeavesContext<LeafIndex_t> const& ctx = *static_cast<LeavesContext<LeafIndex_t>*>(context);
+        const int blockSize = std::min(ctx.rows.blockSize, end - begin);
+        evaluateBlocks(ctx.rows, begin, end, LeafSink<LeafIndex_t>(*ctx.rows.ff, ctx.firstLeaves, ctx.out, blockSize));
+    }
+
+    BlockedRows blockedRows(FastForest const& ff, const FeatureType* array, int rowStride, int blockSize) {
+        BlockedRows rows;
+        rows.ff = &ff;
+        rows.array = array;
+        rows.rowStride = rowStride;
+        rows.blockSize = std::max(blockSize, 1);
+        rows.gatherIndices = NULL;
+        rows.nGathered = 0;
+        return rows;
+    }
+
+}  // namespace
+
+void fastforest::detail::predictBlocked(FastForest const& ff,
+                                        const FeatureType* array,
+                                        int nRows,
+                                        int rowStride,
+                                        TreeEnsembleResponseType* out,
+                                        int nThreads,
+                                        int blockSize,
+                                        const int* gatherIndices,
+                                        int nGathered) {
+    PredictContext<TreeEnsembleResponseType> ctx;
+    ctx.rows = blockedRows(ff, array, rowStride, blockSize);
+    ctx.rows.gatherIndices = gatherIndices;
+    ctx.rows.nGathered = nGathered;
+    ctx.out = out;
+    detail::parallelFor(nRows, nThreads, predictRange<TreeEnsembleResponseType>, &ctx);
+}
+
+void fastforest::FastForest::predict(
+    const FeatureType* array, int nRows, int rowStride, TreeEnsembleResponseType* out, int nThreads) const {
+    detail::predictBlocked(*this, array, nRows, rowStride, out, nThreads, detail::defaultBlockSize);
+}
+
+void fastforest::FastForest::predict(
+    const FeatureType* array, int nRows, int rowStride, double* out, int nThreads) const {
+    PredictContext<double> ctx;
+    ctx.rows = blockedRows(*this, array, rowStride, detail::defaultBlockSize);
+    ctx.out = out;
+    detail::parallelFor(nRows, nThreads, predictRange<double>, &ctx);
+}
+
+void fastforest::FastForest::softmax(const FeatureType* array, double* out) const {
+    if (nClasses() <= 2) {
+        throw std::runtime_error(
+            "Error in FastForest::softmax : binary classification models don't support softmax evaluation. Please "
+            "set the number of classes in the FastForest-creating function if this is a multiclassification model.");
+    }
+    predict(array, 1, 0, out);
+    fastforest::details::softmaxTransformInplace(out, nClasses());
+}
+
+void fastforest::FastForest::prepareLeafIndices() {
+    if (!detail::findFirstLeaves(*this, responses_.size(), firstLeaves_, maxLeavesPerTree_)) {
+        firstLeaves_.clear();
+        throw std::runtime_error(
+            "Error in FastForest::prepareLeafIndices : the forest has child indices that are out of range or cyclic");
+    }
+}
+
+template <class LeafIndex_t>
+void fastforest::FastForest::predictLeavesImpl(
+    const FeatureType* array, int nRows, int rowStride, LeafIndex_t* out, int nThreads) const {
+    // fall back to finding the first leaves in each call for forests that were not prepared
+    std::vector<int> firstLeaves;
+    int maxLeavesPerTree = maxLeavesPerTree_;
+    const int* firstLeavesData = firstLeaves_.data();
+    if (firstLeaves_.size() != rootIndices_.size()) {
+        if (!detail::findFirstLeaves(*this, responses_.size(), firstLeaves, maxLeavesPerTree)) {
+            throw std::runtime_error(
+                "Error in FastForest::predictLeaves : the forest has child indices that are out of range or cyclic");
+        }
+        firstLeavesData = firstLeaves.data();
+    }
+    if (maxLeavesPerTree - 1 > static_cast<int>(std::numeric_limits<LeafIndex_t>::max())) {
+        throw std::runtime_error(
+            "Error in FastForest::predictLeaves : the leaf indices don't fit in the output type, please use the "
+            "int output buffer.");
+    }
+
+    LeavesContext<LeafIndex_t> ctx;
+    ctx.rows = blockedRows(*this, array, rowStride, detail::defaultBlockSize);
+    ctx.firstLeaves = firstLeavesData;
+    ctx.out = out;
+    detail::parallelFor(nRows, nThreads, predictLeavesRange<LeafIndex_t>, &ctx);
+}
+
+void fastforest::FastForest::predictLeaves(
+    const FeatureType* array, int nRows, int rowStride, int* out, int nThreads) const {
+    predictLeavesImpl(array, nRows, rowStride, out, nThreads);
+}
+
+void fastforest::FastForest::predictLeaves(
+    const FeatureType* array, int nRows, int rowStride, unsigned short* out, int nThreads) const {
+    predictLeavesImpl(array, nRows, rowStride, out, nThreads);
+}
+
 FastForest fastforest::load_bin(std::string const& txtpath) {
     std::ifstream ifs(txtpath.c_str(), std::ios::binary);
     return load_bin(ifs);
 }
 
+namespace {
+
+    class StreamReader {
+      public:
+        explicit StreamReader(std::istream& is) : is_(is) {}
+        void read(void* out, std::size_t size) {
+            if (!is_.read(static_cast<char*>(out), size)) {
+                throw std::runtime_error("Error in fastforest::load_bin : unexpected end of the input");
+            }
+        }
+        bool atEnd() { return is_.peek() == std::istream::traits_type::eof(); }
+
+      private:
+        std::istream& is_;
+    };
+
+    // Reads directly from a buffer in memory, checking that no read goes past its end
+    class BufferReader {
+      public:
+        BufferReader(const void* data, std::size_t size) : pos_(static_cast<const char*>(data)), end_(pos_ + size) {}
+        void read(void* out, std::size_t size) {
+            if (size > static_cast<std::size_t>(end_ - pos_)) {
+                throw std::runtime_error("Error in fastforest::load_bin : unexpected end of the buffer");
+            }
+            if (size > 0) {
+                std::memcpy(out, pos_, size);
+            }
+            pos_ += size;
+        }
+        bool atEnd() const { return pos_ == end_; }
+        std::size_t remaining() const { return end_ - pos_; }
+
+      private:
+        const char* pos_;
+        const char* end_;
+    };
+
+    void checkArraySize(int size) {
+        if (size < 0) {
+            throw std::runtime_error("Error in fastforest::load_bin : negative array size");
+        }
+    }
+
+    template <class Type_t>
+    void readVector(BufferReader& reader, std::vector<Type_t>& vec, int size) {
+        checkArraySize(size);
+        if (static_cast<std::size_t>(size) > reader.remaining() / sizeof(Type_t)) {
+            throw std::runtime_error("Error in fastforest::load_bin : unexpected end of the buffer");
+        }
+        vec.resize(size);
+        reader.read(vec.data(), size * sizeof(Type_t));
+    }
+
+    // The size of a stream is not known in advance, so the array is read in chunks. Like this, a corrupted size
+    // can't make the vector allocate much more memory than the stream actually contains.
+    template <class Type_t>
+    void readVector(StreamReader& reader, std::vector<Type_t>& vec, int size) {
+        checkArraySize(size);
+        const std::size_t chunkSize = (1 << 20) / sizeof(Type_t);
+        vec.clear();
+        while (vec.size() < static_cast<std::size_t>(size)) {
+            const std::size_t begin = vec.size();
+            vec.resize(begin + std::min(chunkSize, size - begin));
+            reader.read(&vec[begin], (vec.size() - begin) * sizeof(Type_t));
+        }
+    }
+
+    template <class Reader_t>
+    FastForest loadBin(Reader_t& reader) {
+        FastForest ff;
+
+        int nRootNodes;
+        int nNodes;
+        int nLeaves;
+
+        reader.read(&nRootNodes, sizeof(int));
+        reader.read(&nNodes, sizeof(int));
+        reader.read(&nLeaves, sizeof(int));
+
+        readVector(reader, ff.rootIndices_, nRootNodes);
+        readVector(reader, ff.cutIndices_, nNodes);
+        readVector(reader, ff.cutValues_, nNodes);
+        readVector(reader, ff.leftIndices_, nNodes);
+        readVector(reader, ff.rightIndices_, nNodes);
+        readVector(reader, ff.responses_, nLeaves);
+        readVector(reader, ff.treeNumbers_, nRootNodes);
+
+        int nBaseResponses;
+        reader.read(&nBaseResponses, sizeof(int));
+        readVector(reader, ff.baseResponses_, nBaseResponses);
+
+        // The cover statistics are optional and only stored at the end of the file if present
+        if (!reader.atEnd()) {
+            readVector(reader, ff.nodeCovers_, nNodes);
+            readVector(reader, ff.leafCovers_, nLeaves);
+        }
+
+        return ff;
+    }
+
+}  // namespace
+
+FastForest fastforest::detail::readBin(std::istream& is) {
+    StreamReader reader(is);
+    return loadBin(reader);
+}
+
 FastForest fastforest::load_bin(std::istream& is) {
-    FastForest ff;
-
-    int nRootNodes;
-    int nNodes;
-    int nLeaves;
-
-    is.read((char*)&nRootNodes, sizeof(int));
-    is.read((char*)&nNodes, sizeof(int));
-    is.read((char*)&nLeaves, sizeof(int));
-
-    ff.rootIndices_.resize(nRootNodes);
-    ff.cutIndices_.resize(nNodes);
-    ff.cutValues_.resize(nNodes);
-    ff.leftIndices_.resize(nNodes);
-    ff.rightIndices_.resize(nNodes);
-    ff.responses_.resize(nLeaves);
-    ff.treeNumbers_.resize(nRootNodes);
-
-    is.read((char*)ff.rootIndices_.data(), nRootNodes * sizeof(int));
-    is.read((char*)ff.cutIndices_.data(), nNodes * sizeof(CutIndexType));
-    is.read((char*)ff.cutValues_.data(), nNodes * sizeof(FeatureType));
-    is.read((char*)ff.leftIndices_.data(), nNodes * sizeof(int));
-    is.read((char*)ff.rightIndices_.data(), nNodes * sizeof(int));
-    is.read((char*)ff.responses_.data(), nLeaves * sizeof(TreeResponseType));
-    is.read((char*)ff.treeNumbers_.data(), nRootNodes * sizeof(int));
-
-    int nBaseResponses;
-    is.read((char*)&nBaseResponses, sizeof(int));
-    ff.baseResponses_.resize(nBaseResponses);
-    is.read((char*)ff.baseResponses_.data(), nBaseResponses * sizeof(TreeEnsembleResponseType));
+    FastForest ff = detail::readBin(is);
+    ff.prepareLeafIndices();
+    return ff;
+}
 
+FastForest fastforest::load_bin(const void* data, std::size_t size) {
+    BufferReader reader(data, size);
+    FastForest ff = loadBin(reader);
+    ff.prepareLeafIndices();
     return ff;
 }
 
+void fastforest::detail::writeBin(std::ostream& os, FastForest const& ff) {
+    int nRootNodes = ff.rootIndices_.size();
+    int nNodes = ff.cutValues_.size();
+    int nLeaves = ff.responses_.size();
+    int nBaseResponses = ff.baseResponses_.size();
+
+    os.write((const char*)&nRootNodes, sizeof(int));
+    os.write((const char*)&nNodes, sizeof(int));
+    os.write((const char*)&nLeaves, sizeof(int));
+
+    os.write((const char*)ff.rootIndices_.data(), nRootNodes * sizeof(int));
+    os.write((const char*)ff.cutIndices_.data(), nNodes * sizeof(CutIndexType));
+    os.write((const char*)ff.cutValues_.data(), nNodes * sizeof(FeatureType));
+    os.write((const char*)ff.leftIndices_.data(), nNodes * sizeof(int));
+    os.write((const char*)ff.rightIndices_.data(), nNodes * sizeof(int));
+    os.write((const char*)ff.responses_.data(), nLeaves * sizeof(TreeResponseType));
+    os.write((const char*)ff.treeNumbers_.data(), nRootNodes * sizeof(int));
+
+    os.write((const char*)&nBaseResponses, sizeof(int));
+    os.write((const char*)ff.baseResponses_.data(), nBaseResponses * sizeof(TreeEnsembleResponseType));
+
+    if (!ff.nodeCovers_.empty()) {
+        os.write((const char*)ff.nodeCovers_.data(), nNodes * sizeof(TreeResponseType));
+        os.write((const char*)ff.leafCovers_.data(), nLeaves * sizeof(TreeResponseType));
+    }
+}
+
 void fastforest::FastForest::write_bin(std::string const& filename) const {
     std::ofstream os(filename.c_str(), std::ios::binary);
+    detail::writeBin(os, *this);
+    os.close();
+}
 
-    int nRootNodes = rootIndices_.size();
-    int nNodes = cutValues_.size();
-    int nLeaves = responses_.size();
-    int nBaseResponses = baseResponses_.size();
+namespace {
 
+    // Moves a child index by the given numbers of nodes and leaves, which can also be negative
+    inline int shiftChildIndex(int index, int nodeOffset, int leafOffset) {
+        return index > 0 ? index + nodeOffset : index - leafOffset;
+    }
+
+    // Appends the trees of other to ff, with the tree numbers increased by treeNumberOffset
+    void appendTrees(FastForest& ff, FastForest const& other, int treeNumberOffset) {
+        const bool keepCovers = ff.nodeCovers_.size() == ff.cutValues_.size() &&
+                                ff.leafCovers_.size() == ff.responses_.size() &&
+                                other.nodeCovers_.size() == other.cutValues_.size() &&
+                                other.leafCovers_.size() == other.responses_.size();
+        const int nodeOffset = ff.cutValues_.size();
+        const int leafOffset = ff.responses_.size();
+        for (std::size_t i = 0; i < other.rootIndices_.size(); ++i) {
+            ff.rootIndices_.push_back(other.rootIndices_[i] + nodeOffset);
+            ff.treeNumbers_.push_back(other.treeNumbers_[i] + treeNumberOffset);
+        }
+        for (std::size_t i = 0; i < other.cutValues_.size(); ++i) {
+            ff.leftIndices_.push_back(shiftChildIndex(other.leftIndices_[i], nodeOffset, leafOffset));
+            ff.rightIndices_.push_back(shiftChildIndex(other.rightIndices_[i], nodeOffset, leafOffset));
+        }
+        ff.cutIndices_.insert(ff.cutIndices_.end(), other.cutIndices_.begin(), other.cutIndices_.end());
+        ff.cutValues_.insert(ff.cutValues_.end(), other.cutValues_.begin(), other.cutValues_.end());
+        ff.responses_.insert(ff.responses_.end(), other.responses_.begin(), other.responses_.end());
+        if (keepCovers) {
+            ff.nodeCovers_.insert(ff.nodeCovers_.end(), other.nodeCovers_.begin(), other.nodeCovers_.end());
+            ff.leafCovers_.insert(ff.leafCovers_.end(), other.leafCovers_.begin(), other.leafCovers_.end());
+        } else {
+            ff.nodeCovers_.clear();
+            ff.leafCovers_.clear();
+        }
+    }
+
+    // Delta files start with this tag, followed by the sizes and the fingerprint of the forest they were made for
+    const char deltaMagic[4] = {'F', 'F', 'D', '1'};
+
+    template <class Type_t>
+    bool isPrefix(std::vector<Type_t> const& prefix, std::vector<Type_t> const& vec) {
+        return prefix.size() <= vec.size() && std::equal(prefix.begin(), prefix.end(), vec.begin());
+    }
+
+}  // namespace
+
+void fastforest::FastForest::append(FastForest const& other) {
+    if (other.nOutputs() != nOutputs()) {
+        throw std::runtime_error("Error in FastForest::append : the forests have different numbers of classes");
+    }
+    // the tree numbers are only used to get the class, so they are continued at the next multiple of the classes
+    const int nOut = nOutputs();
+    const int nextTree = treeNumbers_.empty() ? 0 : treeNumbers_.back() + 1;
+    appendTrees(*this, other, (nextTree + nOut - 1) / nOut * nOut);
+    prepareLeafIndices();
+}
+
+void fastforest::write_delta_bin(std::string const& filename, FastForest const& previous, FastForest const& updated) {
+    const int nRootNodes = previous.rootIndices_.size();
+    const int nNodes = previous.cutValues_.size();
+    const int nLeaves = previous.responses_.size();
+    const bool startsWithPrevious =
+        isPrefix(previous.rootIndices_, updated.rootIndices_) && isPrefix(previous.cutIndices_, updated.cutIndices_) &&
+        isPrefix(previous.cutValues_, updated.cutValues_) && isPrefix(previous.leftIndices_, updated.leftIndices_) &&
+        isPrefix(previous.rightIndices_, updated.rightIndices_) && isPrefix(previous.responses_, updated.responses_) &&
+        isPrefix(previous.treeNumbers_, updated.treeNumbers_) &&
+        previous.baseResponses_.size() == updated.baseResponses_.size() &&
+        (updated.rootIndices_.size() == previous.rootIndices_.size() || updated.rootIndices_[nRootNodes] == nNodes);
+    if (!startsWithPrevious) {
+        throw std::runtime_error(
+            "Error in fastforest::write_delta_bin : the updated forest doesn't start with the previous forest");
+    }
+
+    FastForest delta;
+    for (std::size_t i = nRootNodes; i < updated.rootIndices_.size(); ++i) {
+        delta.rootIndices_.push_back(updated.rootIndices_[i] - nNodes);
+        delta.treeNumbers_.push_back(updated.treeNumbers_[i]);
+    }
+    for (std::size_t i = nNodes; i < updated.cutValues_.size(); ++i) {
+        delta.cutIndices_.push_back(updated.cutIndices_[i]);
+        delta.cutValues_.push_back(updated.cutValues_[i]);
+        delta.leftIndices_.push_back(shiftChildIndex(updated.leftIndices_[i], -nNodes, -nLeaves));
+        delta.rightIndices_.push_back(shiftChildIndex(updated.rightIndices_[i], -nNodes, -nLeaves));
+    }
+    delta.responses_.assign(updated.responses_.begin() + nLeaves, updated.responses_.end());
+    if (updated.nodeCovers_.size() == updated.cutValues_.size() && !updated.nodeCovers_.empty()) {
+        delta.nodeCovers_.assign(updated.nodeCovers_.begin() + nNodes, updated.nodeCovers_.end());
+        delta.leafCovers_.assign(updated.leafCovers_.begin() + nLeaves, updated.leafCovers_.end());
+    }
+    // the base responses are stored as they are in the updated forest, since they can also contain single-leaf trees
+    delta.baseResponses_ = updated.baseResponses_;
+
+    const unsigned int previousFingerprint = detail::fingerprint(previous);
+
+    std::ofstream os(filename.c_str(), std::ios::binary);
+    os.write(deltaMagic, sizeof(deltaMagic));
     os.write((const char*)&nRootNodes, sizeof(int));
     os.write((const char*)&nNodes, sizeof(int));
     os.write((const char*)&nLeaves, sizeof(int));
+    os.write((const char*)&previousFingerprint, sizeof(unsigned int));
+    detail::writeBin(os, delta);
+    os.close();
+}
 
-    os.write((const char*)rootIndices_.data(), nRootNodes * sizeof(int));
-    os.write((const char*)cutIndices_.data(), nNodes * sizeof(CutIndexType));
-    os.write((const char*)cutValues_.data(), nNodes * sizeof(FeatureType));
-    os.write((const char*)leftIndices_.data(), nNodes * sizeof(int));
-    os.write((const char*)rightIndices_.data(), nNodes * sizeof(int));
-    os.write((const char*)responses_.data(), nLeaves * sizeof(TreeResponseType));
-    os.write((const char*)treeNumbers_.data(), nRootNodes * sizeof(int));
+void fastforest::FastForest::append_delta_bin(std::string const& filename) {
+    std::ifstream is(filename.c_str(), std::ios::binary);
+    if (!is) {
+        throw std::runtime_error("Error in FastForest::append_delta_bin : can't open " + filename);
+    }
+    append_delta_bin(is);
+}
 
-    os.write((const char*)&nBaseResponses, sizeof(int));
-    os.write((const char*)baseResponses_.data(), nBaseResponses * sizeof(TreeEnsembleResponseType));
-    os.close();
+void fastforest::FastForest::append_delta_bin(std::istream& is) {
+    StreamReader reader(is);
+    char magic[sizeof(deltaMagic)];
+    reader.read(magic, sizeof(magic));
+    if (std::memcmp(magic, deltaMagic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Error in FastForest::append_delta_bin : this is not a delta file");
+    }
+    int sizesBefore[3];
+    unsigned int previousFingerprint;
+    reader.read(sizesBefore, sizeof(sizesBefore));
+    reader.read(&previousFingerprint, sizeof(unsigned int));
+    // the sizes are compared first, since the fingerprint has to go over all arrays
+    if (sizesBefore[0] != nTrees() || sizesBefore[1] != static_cast<int>(cutValues_.size()) ||
+        sizesBefore[2] != static_cast<int>(responses_.size()) || previousFingerprint != detail::fingerprint(*this)) {
+        throw std::runtime_error("Error in FastForest::append_delta_bin : the update was made for a different forest");
+    }
+    const FastForest delta = loadBin(reader);
+    if (!is || delta.baseResponses_.size() != baseResponses_.size()) {
+        throw std::runtime_error("Error in FastForest::append_delta_bin : the update is corrupted");
+    }
+    appendTrees(*this, delta, 0);
+    baseResponses_ = delta.baseResponses_;
+    prepareLeafIndices();
 }
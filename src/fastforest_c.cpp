@@ -0,0 +1,274 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "fastforest_c.h"
+#include "fastforest.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct fastforest_forest {
+    fastforest::FastForest forest;
+    std::vector<std::string> features;
+};
+
+namespace {
+
+    void setError(char* error, size_t errorSize, const char* message) {
+        if (error && errorSize > 0) {
+            std::strncpy(error, message, errorSize - 1);
+            error[errorSize - 1] = '\0';
+        }
+    }
+
+    std::vector<std::string> featureNames(const char* const* features, int nFeatures) {
+        std::vector<std::string> names;
+        for (int i = 0; features && i < nFeatures; ++i) {
+            names.push_back(features[i]);
+        }
+        return names;
+    }
+
+    // The binary format doesn't store the feature names, so they are named after the input columns
+    void setDefaultFeatures(fastforest_forest* ff) {
+        std::size_t nFeatures = 0;
+        for (std::size_t i = 0; i < ff->forest.cutIndices_.size(); ++i) {
+            nFeatures = std::max(nFeatures, static_cast<std::size_t>(ff->forest.cutIndices_[i]) + 1);
+        }
+        for (std::size_t i = 0; i < nFeatures; ++i) {
+            std::stringstream ss;
+            ss << "f" << i;
+            ff->features.push_back(ss.str());
+        }
+    }
+
+    void checkForest(const fastforest_forest* forest) {
+        if (!forest) {
+            throw std::runtime_error("Error in fastforest C API : forest is NULL");
+        }
+    }
+
+    void checkPath(const char* path) {
+        if (!path) {
+            throw std::runtime_error("Error in fastforest C API : path is NULL");
+        }
+    }
+
+    void checkArguments(const fastforest_forest* forest, const void* array, int nRows, const void* out) {
+        checkForest(forest);
+        if (nRows < 0 || (nRows > 0 && (!array || !out))) {
+            throw std::runtime_error("Error in fastforest C API : invalid input or output arrays");
+        }
+    }
+
+}  // namespace
+
+extern "C" {
+
+fastforest_forest* fastforest_load_txt(const char* path,
+                                       const char* const* features,
+                                       int nFeatures,
+                                       int nClasses,
+                                       char* error,
+                                       size_t errorSize) {
+    fastforest_forest* ff = NULL;
+    try {
+        checkPath(path);
+        ff = new fastforest_forest;
+        ff->features = featureNames(features, nFeatures);
+        ff->forest = fastforest::load_txt(path, ff->features, nClasses);
+        return ff;
+    } catch (std::exception const& e) {
+        delete ff;
+        setError(error, errorSize, e.what());
+        return NULL;
+    }
+}
+
+fastforest_forest* fastforest_load_txt_buffer(const char* text,
+                                              size_t size,
+                                              const char* const* features,
+                                              int nFeatures,
+                                              int nClasses,
+                                              char* error,
+                                              size_t errorSize) {
+    fastforest_forest* ff = NULL;
+    try {
+        ff = new fastforest_forest;
+        ff->features = featureNames(features, nFeatures);
+        ff->forest = fastforest::load_txt(text, size, ff->features, nClasses);
+        return ff;
+    } catch (std::exception const& e) {
+        delete ff;
+        setError(error, errorSize, e.what());
+        return NULL;
+    }
+}
+
+fastforest_forest* fastforest_load_bin(const char* path, char* error, size_t errorSize) {
+    fastforest_forest* ff = NULL;
+    try {
+        checkPath(path);
+        std::ifstream is(path, std::ios::binary);
+        if (!is) {
+            throw std::runtime_error(std::string("Error in fastforest C API : can't open ") + path);
+        }
+        ff = new fastforest_forest;
+        ff->forest = fastforest::load_bin(is);
+        if (is.fail()) {
+            throw std::runtime_error(std::string("Error in fastforest C API : can't read ") + path);
+        }
+        setDefaultFeatures(ff);
+        return ff;
+    } catch (std::exception const& e) {
+        delete ff;
+        setError(error, errorSize, e.what());
+        return NULL;
+    }
+}
+
+fastforest_forest* fastforest_load_bin_buffer(const void* data, size_t size, char* error, size_t errorSize) {
+    fastforest_forest* ff = NULL;
+    try {
+        ff = new fastforest_forest;
+        ff->forest = fastforest::load_bin(data, size);
+        setDefaultFeatures(ff);
+        return ff;
+    } catch (std::exception const& e) {
+        delete ff;
+        setError(error, errorSize, e.what());
+        return NULL;
+    }
+}
+
+int fastforest_write_bin(const fastforest_forest* forest, const char* path, char* error, size_t errorSize) {
+    try {
+        checkForest(forest);
+        checkPath(path);
+        forest->forest.write_bin(path);
+        return 0;
+    } catch (std::exception const& e) {
+        setError(error, errorSize, e.what());
+        return 1;
+    }
+}
+
+void fastforest_free(fastforest_forest* forest) { delete forest; }
+
+int fastforest_n_features(const fastforest_forest* forest) { return forest ? forest->features.size() : 0; }
+
+const char* fastforest_feature_name(const fastforest_forest* forest, int index) {
+    if (!forest || index < 0 || index >= static_cast<int>(forest->features.size())) {
+        return NULL;
+    }
+    return forest->features[index].c_str();
+}
+
+int fastforest_n_classes(const fastforest_forest* forest) { return forest ? forest->forest.nClasses() : 0; }
+
+int fastforest_n_trees(const fastforest_forest* forest) { return forest ? forest->forest.nTrees() : 0; }
+
+int fastforest_n_outputs(const fastforest_forest* forest) { return forest ? forest->forest.nOutputs() : 0; }
+
+int fastforest_predict(const fastforest_forest* forest,
+                       const float* array,
+                       int nRows,
+                       int rowStride,
+                       float* out,
+                       int nThreads,
+                       char* error,
+                       size_t errorSize) {
+    try {
+        checkArguments(forest, array, nRows, out);
+        forest->forest.predict(array, nRows, rowStride, out, nThreads);
+        return 0;
+    } catch (std::exception const& e) {
+        setError(error, errorSize, e.what());
+        return 1;
+    }
+}
+
+int fastforest_predict_double(const fastforest_forest* forest,
+                              const float* array,
+                              int nRows,
+                              int rowStride,
+                              double* out,
+                              int nThreads,
+                              char* error,
+                              size_t errorSize) {
+    try {
+        checkArguments(forest, array, nRows, out);
+        forest->forest.predict(array, nRows, rowStride, out, nThreads);
+        return 0;
+    } catch (std::exception const& e) {
+        setError(error, errorSize, e.what());
+        return 1;
+    }
+}
+
+int fastforest_softmax(const fastforest_forest* forest,
+                       const float* array,
+                       int nRows,
+                       int rowStride,
+                       float* out,
+                       int nThreads,
+                       char* error,
+                       size_t errorSize) {
+    if (fastforest_predict(forest, array, nRows, rowStride, out, nThreads, error, errorSize) != 0) {
+        return 1;
+    }
+    const int nOut = forest->forest.nOutputs();
+    if (nOut > 1) {
+        for (int i = 0; i < nRows; ++i) {
+            fastforest::details::softmaxTransformInplace(out + static_cast<std::size_t>(i) * nOut, nOut);
+        }
+    }
+    return 0;
+}
+
+int fastforest_predict_leaves(const fastforest_forest* forest,
+                              const float* array,
+                              int nRows,
+                              int rowStride,
+                              int* out,
+                              char* error,
+                              size_t errorSize) {
+    try {
+        checkArguments(forest, array, nRows, out);
+        forest->forest.predictLeaves(array, nRows, rowStride, out);
+        return 0;
+    } catch (std::exception const& e) {
+        setError(error, errorSize, e.what());
+        return 1;
+    }
+}
+
+}  // extern "C"
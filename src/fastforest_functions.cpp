@@ -27,17 +27,20 @@ SOFTWARE.
 #include <fastforest.h>
 #include "common_details.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <limits>
 #include <map>
 #include <sstream>
 #include <stdexcept>
 #include <stdlib.h> /* strtol */
 #include <string>
+#include <utility>
 
 using namespace fastforest;
 
@@ -192,7 +195,8 @@ namespace {
                        int& nPreviousLeaves,
                        fastforest::detail::IndexMap& nodeIndices,
                        fastforest::detail::IndexMap& leafIndices,
-                       int& treesSkipped) {
+                       int& treesSkipped,
+                       std::vector<std::pair<int, TreeResponseType> >* skippedTrees) {
         using namespace fastforest::detail;
         correctIndices(ff.rightIndices_.begin() + nPreviousNodes, ff.rightIndices_.end(), nodeIndices, leafIndices);
         correctIndices(ff.leftIndices_.begin() + nPreviousNodes, ff.leftIndices_.end(), nodeIndices, leafIndices);
@@ -203,7 +207,15 @@ namespace {
         } else {
             int treeNumbers = ff.rootIndices_.size() + treesSkipped;
             ++treesSkipped;
-            ff.baseResponses_[treeNumbers % ff.baseResponses_.size()] += ff.responses_.back();
+            if (skippedTrees) {
+                // collected to be added later in the right order, when parsing a dump in several parts
+                skippedTrees->push_back(std::make_pair(treeNumbers, ff.responses_.back()));
+            } else {
+                ff.baseResponses_[treeNumbers % ff.baseResponses_.size()] += ff.responses_.back();
+            }
+            if (ff.leafCovers_.size() == ff.responses_.size()) {
+                ff.leafCovers_.pop_back();
+            }
             ff.responses_.pop_back();
         }
 
@@ -215,168 +227,403 @@ namespace {
 
 }  // namespace
 
-FastForest fastforest::load_txt(std::string const& txtpath, std::vector<std::string>& features, int nClasses) {
-    const std::string info = "constructing FastForest from " + txtpath + ": ";
 
-    if (!util::exists(txtpath)) {
-        throw std::runtime_error(info + "file does not exists");
-    }
 
-    std::ifstream file(txtpath.c_str());
-    return load_txt(file, features, nClasses);
-}
+namespace {
 
-FastForest fastforest::load_txt(std::istream& file, std::vector<std::string>& features, int nClasses) {
-    if (nClasses < 2) {
-        throw std::runtime_error("Error in fastforest::load_txt : nClasses has to be at least two");
+    class StreamLines {
+      public:
+        explicit StreamLines(std::istream& is) : is_(is) {}
+        bool getline(std::string& line) { return static_cast<bool>(std::getline(is_, line)); }
+
+      private:
+        std::istream& is_;
+    };
+
+    // Splits a buffer in memory into lines, without copying the whole buffer first
+    class BufferLines {
+      public:
+        BufferLines(const void* data, std::size_t size) : pos_(static_cast<const char*>(data)), end_(pos_ + size) {}
+        bool getline(std::string& line) {
+            if (pos_ == end_) {
+                return false;
+            }
+            const char* newline = static_cast<const char*>(std::memchr(pos_, '\n', end_ - pos_));
+            const char* lineEnd = newline ? newline : end_;
+            line.assign(pos_, lineEnd);
+            pos_ = newline ? newline + 1 : end_;
+            return true;
+        }
+
+      private:
+        const char* pos_;
+        const char* end_;
+    };
+
+    // Parses the trees of a text dump into ff, whose base responses have to be sized for the number of classes. The
+    // lines can also be a part of the dump that starts with the tree number firstTree. Single-leaf trees are added to
+    // the base responses, or collected in skippedTrees if given. Returns the number of the tree after the last parsed
+    // one, counting also the single-leaf trees.
+    template <class Lines_t>
+    int parseTxt(Lines_t& lines,
+                 FastForest& ff,
+                 std::vector<std::string>& features,
+                 int firstTree,
+                 std::vector<TreeEnsembleResponseType>& baseScore,
+                 std::vector<std::pair<int, TreeResponseType> >* skippedTrees,
+                 std::string const& info) {
+        int treesSkipped = firstTree;
+
+        int nVariables = 0;
+        std::map<std::string, int> varIndices;
+        bool fixFeatures = false;
+
+        if (!features.empty()) {
+            fixFeatures = true;
+            nVariables = features.size();
+            for (int i = 0; i < nVariables; ++i) {
+                varIndices[features[i]] = i;
+            }
+        }
+
+        std::string line;
+
+        fastforest::detail::IndexMap nodeIndices;
+        fastforest::detail::IndexMap leafIndices;
+
+        int nPreviousNodes = 0;
+        int nPreviousLeaves = 0;
+
+        while (lines.getline(line)) {
+            std::size_t foundBegin = line.find("[");
+            std::size_t foundEnd = line.find("]");
+            util::AfterSubstrOutput<TreeResponseType> leafOutput = util::afterSubstr<TreeResponseType>(line, "leaf=");
+            std::string baseScoreOutput = util::strAfterSubstr(line, "base_score=");
+            if (!baseScoreOutput.empty()) {
+                util::parseList(baseScore, baseScoreOutput);
+            } else if (foundBegin != std::string::npos) {
+                std::string subline = line.substr(foundBegin + 1, foundEnd - foundBegin - 1);
+                if (util::isInteger(subline) && !ff.responses_.empty()) {
+                    terminateTree(
+                        ff, nPreviousNodes, nPreviousLeaves, nodeIndices, leafIndices, treesSkipped, skippedTrees);
+                } else if (!util::isInteger(subline)) {
+                    std::stringstream ss(line);
+                    int index;
+                    ss >> index;
+                    line = ss.str();
+
+                    std::vector<std::string> splitstring = util::split(subline, '<');
+                    std::string const& varName = splitstring[0];
+                    FeatureType cutValue;
+                    {
+                        bool lessEqual = false;
+                        if (splitstring[1][0] == '=') {
+                            splitstring[1] = splitstring[1].substr(1);
+                            lessEqual = true;
+                        }
+                        std::stringstream ss(splitstring[1]);
+                        ss >> cutValue;
+                        if (lessEqual) {
+                            FeatureType val = cutValue;
+                            cutValue = util::nextafter(val, std::numeric_limits<FeatureType>::infinity());
+    #if __cplusplus >= 201103L
+                            assert(cutValue == std::nextafter(val, std::numeric_limits<FeatureType>::infinity()));
+    #endif
+                        }
+                    }
+                    if (!varIndices.count(varName)) {
+                        if (fixFeatures) {
+                            throw std::runtime_error(info + "feature " + varName + " not in list of features");
+                        }
+                        varIndices[varName] = nVariables;
+                        features.push_back(varName);
+                        ++nVariables;
+                    }
+                    int yes;
+                    int no;
+                    util::AfterSubstrOutput<int> output = util::afterSubstr<int>(line, "yes=");
+                    if (!output.failed) {
+                        yes = output.value;
+                    } else {
+                        throw std::runtime_error(info + "problem while parsing the text dump");
+                    }
+                    output = util::afterSubstr<int>(output.rest, "no=");
+                    if (!output.failed) {
+                        no = output.value;
+                    } else {
+                        throw std::runtime_error(info + "problem while parsing the text dump");
+                    }
+
+                    util::AfterSubstrOutput<TreeResponseType> coverOutput =
+                        util::afterSubstr<TreeResponseType>(line, "cover=");
+                    if (!coverOutput.failed) {
+                        ff.nodeCovers_.push_back(coverOutput.value);
+                    }
+
+                    ff.cutValues_.push_back(cutValue);
+                    ff.cutIndices_.push_back(varIndices[varName]);
+                    ff.leftIndices_.push_back(yes);
+                    ff.rightIndices_.push_back(no);
+                    std::size_t nNodeIndices = nodeIndices.size();
+                    nodeIndices[index] = nNodeIndices + nPreviousNodes;
+                }
+
+            } else if (leafOutput.found) {
+                std::stringstream ss(line);
+                int index;
+                ss >> index;
+                line = ss.str();
+
+                util::AfterSubstrOutput<TreeResponseType> coverOutput =
+                    util::afterSubstr<TreeResponseType>(line, "cover=");
+                if (!coverOutput.failed) {
+                    ff.leafCovers_.push_back(coverOutput.value);
+                }
+
+                ff.responses_.push_back(leafOutput.value);
+                std::size_t nLeafIndices = leafIndices.size();
+                leafIndices[index] = nLeafIndices + nPreviousLeaves;
+            }
+        }
+        terminateTree(ff, nPreviousNodes, nPreviousLeaves, nodeIndices, leafIndices, treesSkipped, skippedTrees);
+        return ff.rootIndices_.size() + treesSkipped;
     }
 
-    const std::string info = "constructing FastForest from istream: ";
+    // Checks the parsed forest for consistency and adds the base score, nTrees being the number of trees in the dump
+    void finishTxt(FastForest& ff, int nTrees, int nClasses, std::vector<TreeEnsembleResponseType> const& baseScore) {
+        if (baseScore.empty()) {
+            std::stringstream ss;
+            ss << "\nERROR: The model dump is missing the required base_score=<float> line.\n"
+               << "       Without this hint, FastForest cannot guarantee correct parsing,\n"
+               << "       and inference results may be silently incorrect.\n\n"
+               << "To ensure the version hint is always consistent with the actual model\n"
+               << "you trained, we recommend appending the required line\n"
+               << "right after dumping the model. For example:\n\n"
+               << "    outfile = \"model.txt\"\n"
+               << "    booster = model.get_booster()\n"
+               << "    # Dump the model to a .txt file\n"
+               << "    booster.dump_model(outfile, fmap=\"\", with_stats=False, dump_format=\"text\")\n"
+               << "    # Append the base score (unfortunately missing in the .txt dump)\n"
+               << "    with open(outfile, \"a\") as f:\n"
+               << "        import json\n"
+               << "\n"
+               << "        json_dump = json.loads(booster.save_config())\n"
+               << "        base_score_str = json_dump[\"learner\"][\"learner_model_param\"][\"base_score\"]\n"
+               << "        base_score = json.loads(base_score_str)\n"
+               << "        if isinstance(base_score, float):\n"
+               << "            # Before XGBoost 3.1.0, this was a single float.\n"
+               << "            # So we have to pack it into a list ourselves.\n"
+               << "            base_score = [base_score]\n"
+               << "        f.write(f\"base_score={base_score}\\n\")\n\n";
+            throw std::runtime_error(ss.str());
+        }
+
+        if (nClasses > 2 && nTrees % nClasses != 0) {
+            std::stringstream ss;
+            ss << "Error in FastForest construction : Forest has " << ff.rootIndices_.size()
+               << " trees, which is not compatible with " << nClasses << "classes!";
+            throw std::runtime_error(ss.str());
+        }
 
-    FastForest ff;
-    ff.baseResponses_.resize(nClasses == 2 ? 1 : nClasses);
+        for (std::size_t i = 0; i < ff.baseResponses_.size(); ++i) {
+            ff.baseResponses_[i] += baseScore.size() == 1 ? baseScore[0] : baseScore[i];
+        }
 
-    int treesSkipped = 0;
+        // The cover statistics are only kept if they were dumped for every node, i.e. with `with_stats=True`.
+        if (ff.nodeCovers_.size() != ff.cutValues_.size() || ff.leafCovers_.size() != ff.responses_.size()) {
+            ff.nodeCovers_.clear();
+            ff.leafCovers_.clear();
+        }
 
-    int nVariables = 0;
-    std::map<std::string, int> varIndices;
-    bool fixFeatures = false;
+        ff.prepareLeafIndices();
+    }
 
-    if (!features.empty()) {
-        fixFeatures = true;
-        nVariables = features.size();
-        for (int i = 0; i < nVariables; ++i) {
-            varIndices[features[i]] = i;
+    void checkNClasses(int nClasses) {
+        if (nClasses < 2) {
+            throw std::runtime_error("Error in fastforest::load_txt : nClasses has to be at least two");
         }
     }
 
-    std::string line;
+    template <class Lines_t>
+    FastForest loadTxt(Lines_t& lines, std::vector<std::string>& features, int nClasses, std::string const& info) {
+        checkNClasses(nClasses);
 
-    fastforest::detail::IndexMap nodeIndices;
-    fastforest::detail::IndexMap leafIndices;
+        FastForest ff;
+        ff.baseResponses_.resize(nClasses == 2 ? 1 : nClasses);
 
-    int nPreviousNodes = 0;
-    int nPreviousLeaves = 0;
+        std::vector<TreeEnsembleResponseType> baseScore;
+        const int nTrees = parseTxt(lines, ff, features, 0, baseScore, NULL, info);
+        finishTxt(ff, nTrees, nClasses, baseScore);
+        return ff;
+    }
 
-    std::vector<TreeEnsembleResponseType> baseScore;
+    // A part of a text dump with consecutive trees, which is parsed by its own thread into a partial forest with its
+    // own feature indices
+    struct TxtChunk {
+        const char* begin;
+        const char* end;
+        int firstTree;
+        int endTree;
+        FastForest ff;
+        std::vector<std::string> features;
+        std::vector<TreeEnsembleResponseType> baseScore;
+        std::vector<std::pair<int, TreeResponseType> > skippedTrees;
+        // the message of an exception that was thrown while parsing, because it can't cross the thread boundary
+        std::string error;
+    };
+
+    struct TxtChunksContext {
+        std::vector<TxtChunk>* chunks;
+        std::string const* info;
+    };
+
+    void parseTxtChunks(int begin, int end, void* context) {
+        TxtChunksContext const& ctx = *static_cast<TxtChunksContext*>(context);
+        for (int i = begin; i < end; ++i) {
+            TxtChunk& chunk = (*ctx.chunks)[i];
+            try {
+                BufferLines lines(chunk.begin, chunk.end - chunk.begin);
+                chunk.endTree = parseTxt(
+                    lines, chunk.ff, chunk.features, chunk.firstTree, chunk.baseScore, &chunk.skippedTrees, *ctx.info);
+            } catch (std::exception const& e) {
+                chunk.error = e.what();
+            }
+        }
+    }
 
-    while (std::getline(file, line)) {
-        std::size_t foundBegin = line.find("[");
-        std::size_t foundEnd = line.find("]");
-        util::AfterSubstrOutput<TreeResponseType> leafOutput = util::afterSubstr<TreeResponseType>(line, "leaf=");
-        std::string baseScoreOutput = util::strAfterSubstr(line, "base_score=");
-        if (!baseScoreOutput.empty()) {
-            util::parseList(baseScore, baseScoreOutput);
-        } else if (foundBegin != std::string::npos) {
-            std::string subline = line.substr(foundBegin + 1, foundEnd - foundBegin - 1);
-            if (util::isInteger(subline) && !ff.responses_.empty()) {
-                terminateTree(ff, nPreviousNodes, nPreviousLeaves, nodeIndices, leafIndices, treesSkipped);
-            } else if (!util::isInteger(subline)) {
-                std::stringstream ss(line);
-                int index;
-                ss >> index;
-                line = ss.str();
+    // Moves a child index of a partial forest to its position in the merged forest
+    inline int shiftIndex(int index, int nodeOffset, int leafOffset) {
+        return index > 0 ? index + nodeOffset : index - leafOffset;
+    }
 
-                std::vector<std::string> splitstring = util::split(subline, '<');
-                std::string const& varName = splitstring[0];
-                FeatureType cutValue;
-                {
-                    bool lessEqual = false;
-                    if (splitstring[1][0] == '=') {
-                        splitstring[1] = splitstring[1].substr(1);
-                        lessEqual = true;
-                    }
-                    std::stringstream ss(splitstring[1]);
-                    ss >> cutValue;
-                    if (lessEqual) {
-                        FeatureType val = cutValue;
-                        cutValue = util::nextafter(val, std::numeric_limits<FeatureType>::infinity());
-#if __cplusplus >= 201103L
-                        assert(cutValue == std::nextafter(val, std::numeric_limits<FeatureType>::infinity()));
-#endif
-                    }
-                }
-                if (!varIndices.count(varName)) {
-                    if (fixFeatures) {
-                        throw std::runtime_error(info + "feature " + varName + " not in list of features");
-                    }
-                    varIndices[varName] = nVariables;
-                    features.push_back(varName);
-                    ++nVariables;
-                }
-                int yes;
-                int no;
-                util::AfterSubstrOutput<int> output = util::afterSubstr<int>(line, "yes=");
-                if (!output.failed) {
-                    yes = output.value;
-                } else {
-                    throw std::runtime_error(info + "problem while parsing the text dump");
-                }
-                output = util::afterSubstr<int>(output.rest, "no=");
-                if (!output.failed) {
-                    no = output.value;
-                } else {
-                    throw std::runtime_error(info + "problem while parsing the text dump");
-                }
+    // Splits a text dump in memory at the `booster[N]:` lines into one part per thread, parses the parts concurrently,
+    // and concatenates the partial forests. The features are numbered in the order of their first appearance in the
+    // dump like in the serial parser, so the result is exactly the same.
+    FastForest loadTxtParallel(const char* data,
+                               std::size_t size,
+                               std::vector<std::string>& features,
+                               int nClasses,
+                               int nThreads,
+                               std::string const& info) {
+        if (nThreads <= 1) {
+            BufferLines lines(data, size);
+            return loadTxt(lines, features, nClasses, info);
+        }
 
-                ff.cutValues_.push_back(cutValue);
-                ff.cutIndices_.push_back(varIndices[varName]);
-                ff.leftIndices_.push_back(yes);
-                ff.rightIndices_.push_back(no);
-                std::size_t nNodeIndices = nodeIndices.size();
-                nodeIndices[index] = nNodeIndices + nPreviousNodes;
+        std::vector<const char*> treeBegins;
+        const char* end = data + size;
+        for (const char* pos = data; pos < end;) {
+            if (end - pos >= 8 && std::memcmp(pos, "booster[", 8) == 0) {
+                treeBegins.push_back(pos);
             }
+            const char* newline = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+            pos = newline ? newline + 1 : end;
+        }
+        const int nTrees = treeBegins.size();
+        const int nChunks = std::min(nThreads, nTrees);
+        if (nChunks <= 1) {
+            BufferLines lines(data, size);
+            return loadTxt(lines, features, nClasses, info);
+        }
+        checkNClasses(nClasses);
+
+        const int nOut = nClasses == 2 ? 1 : nClasses;
+        std::vector<TxtChunk> chunks(nChunks);
+        for (int i = 0; i < nChunks; ++i) {
+            TxtChunk& chunk = chunks[i];
+            chunk.firstTree = static_cast<long>(nTrees) * i / nChunks;
+            const int chunkEndTree = static_cast<long>(nTrees) * (i + 1) / nChunks;
+            // the first and last part also contain the lines before the first and after the last tree
+            chunk.begin = i == 0 ? data : treeBegins[chunk.firstTree];
+            chunk.end = i == nChunks - 1 ? end : treeBegins[chunkEndTree];
+            chunk.endTree = chunk.firstTree;
+            chunk.ff.baseResponses_.resize(nOut);
+            // with a given list of features, all parts use the same feature indices
+            chunk.features = features;
+        }
+        TxtChunksContext ctx;
+        ctx.chunks = &chunks;
+        ctx.info = &info;
+        detail::parallelFor(nChunks, nThreads, parseTxtChunks, &ctx);
+
+        std::map<std::string, int> featureIndices;
+        for (std::size_t i = 0; i < features.size(); ++i) {
+            featureIndices[features[i]] = i;
+        }
 
-        } else if (leafOutput.found) {
-            std::stringstream ss(line);
-            int index;
-            ss >> index;
-            line = ss.str();
+        FastForest ff;
+        ff.baseResponses_.resize(nOut);
+        std::vector<TreeEnsembleResponseType> baseScore;
+        for (int i = 0; i < nChunks; ++i) {
+            TxtChunk const& chunk = chunks[i];
+            if (!chunk.error.empty()) {
+                throw std::runtime_error(chunk.error);
+            }
 
-            ff.responses_.push_back(leafOutput.value);
-            std::size_t nLeafIndices = leafIndices.size();
-            leafIndices[index] = nLeafIndices + nPreviousLeaves;
+            std::vector<CutIndexType> featureMap(chunk.features.size());
+            for (std::size_t j = 0; j < chunk.features.size(); ++j) {
+                std::map<std::string, int>::const_iterator found = featureIndices.find(chunk.features[j]);
+                if (found == featureIndices.end()) {
+                    found = featureIndices.insert(std::make_pair(chunk.features[j], int(features.size()))).first;
+                    features.push_back(chunk.features[j]);
+                }
+                featureMap[j] = found->second;
+            }
+
+            const int nodeOffset = ff.cutValues_.size();
+            const int leafOffset = ff.responses_.size();
+            FastForest const& part = chunk.ff;
+            for (std::size_t j = 0; j < part.rootIndices_.size(); ++j) {
+                ff.rootIndices_.push_back(part.rootIndices_[j] + nodeOffset);
+            }
+            for (std::size_t j = 0; j < part.cutIndices_.size(); ++j) {
+                ff.cutIndices_.push_back(featureMap[part.cutIndices_[j]]);
+                ff.leftIndices_.push_back(shiftIndex(part.leftIndices_[j], nodeOffset, leafOffset));
+                ff.rightIndices_.push_back(shiftIndex(part.rightIndices_[j], nodeOffset, leafOffset));
+            }
+            ff.cutValues_.insert(ff.cutValues_.end(), part.cutValues_.begin(), part.cutValues_.end());
+            ff.responses_.insert(ff.responses_.end(), part.responses_.begin(), part.responses_.end());
+            ff.treeNumbers_.insert(ff.treeNumbers_.end(), part.treeNumbers_.begin(), part.treeNumbers_.end());
+            ff.nodeCovers_.insert(ff.nodeCovers_.end(), part.nodeCovers_.begin(), part.nodeCovers_.end());
+            ff.leafCovers_.insert(ff.leafCovers_.end(), part.leafCovers_.begin(), part.leafCovers_.end());
+            for (std::size_t j = 0; j < chunk.skippedTrees.size(); ++j) {
+                ff.baseResponses_[chunk.skippedTrees[j].first % nOut] += chunk.skippedTrees[j].second;
+            }
+            baseScore.insert(baseScore.end(), chunk.baseScore.begin(), chunk.baseScore.end());
         }
+
+        finishTxt(ff, chunks.back().endTree, nClasses, baseScore);
+        return ff;
     }
-    terminateTree(ff, nPreviousNodes, nPreviousLeaves, nodeIndices, leafIndices, treesSkipped);
-
-    if (baseScore.empty()) {
-        std::stringstream ss;
-        ss << "\nERROR: The model dump is missing the required base_score=<float> line.\n"
-           << "       Without this hint, FastForest cannot guarantee correct parsing,\n"
-           << "       and inference results may be silently incorrect.\n\n"
-           << "To ensure the version hint is always consistent with the actual model\n"
-           << "you trained, we recommend appending the required line\n"
-           << "right after dumping the model. For example:\n\n"
-           << "    outfile = \"model.txt\"\n"
-           << "    booster = model.get_booster()\n"
-           << "    # Dump the model to a .txt file\n"
-           << "    booster.dump_model(outfile, fmap=\"\", with_stats=False, dump_format=\"text\")\n"
-           << "    # Append the base score (unfortunately missing in the .txt dump)\n"
-           << "    with open(outfile, \"a\") as f:\n"
-           << "        import json\n"
-           << "\n"
-           << "        json_dump = json.loads(booster.save_config())\n"
-           << "        base_score_str = json_dump[\"learner\"][\"learner_model_param\"][\"base_score\"]\n"
-           << "        base_score = json.loads(base_score_str)\n"
-           << "        if isinstance(base_score, float):\n"
-           << "            # Before XGBoost 3.1.0, this was a single float.\n"
-           << "            # So we have to pack it into a list ourselves.\n"
-           << "            base_score = [base_score]\n"
-           << "        f.write(f\"base_score={base_score}\\n\")\n\n";
-        throw std::runtime_error(ss.str());
-    }
 
-    if (nClasses > 2 && (ff.rootIndices_.size() + treesSkipped) % nClasses != 0) {
-        std::stringstream ss;
-        ss << "Error in FastForest construction : Forest has " << ff.rootIndices_.size()
-           << " trees, which is not compatible with " << nClasses << "classes!";
-        throw std::runtime_error(ss.str());
+}  // namespace
+
+FastForest fastforest::load_txt(std::istream& file, std::vector<std::string>& features, int nClasses) {
+    StreamLines lines(file);
+    return loadTxt(lines, features, nClasses, "constructing FastForest from istream: ");
+}
+
+FastForest fastforest::load_txt(std::string const& txtpath,
+                                std::vector<std::string>& features,
+                                int nClasses,
+                                int nThreads) {
+    const std::string info = "constructing FastForest from " + txtpath + ": ";
+
+    if (!util::exists(txtpath)) {
+        throw std::runtime_error(info + "file does not exists");
     }
 
-    for (std::size_t i = 0; i < ff.baseResponses_.size(); ++i) {
-        ff.baseResponses_[i] += baseScore.size() == 1 ? baseScore[0] : baseScore[i];
+    std::ifstream file(txtpath.c_str());
+    if (nThreads <= 1) {
+        return load_txt(file, features, nClasses);
     }
+    // the parallel parser needs the whole file in memory to split it
+    const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return loadTxtParallel(content.data(), content.size(), features, nClasses, nThreads, info);
+}
 
-    return ff;
+FastForest fastforest::load_txt(
+    const void* data, std::size_t size, std::vector<std::string>& features, int nClasses, int nThreads) {
+    return loadTxtParallel(
+        static_cast<const char*>(data), size, features, nClasses, nThreads, "constructing FastForest from buffer: ");
 }
@@ -0,0 +1,166 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+#include "common_details.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace fastforest;
+
+namespace {
+
+    // Number of grid cells that are evaluated together when the table is filled
+    const int cellsPerBlock = 256;
+
+}  // namespace
+
+bool fastforest::compile_grid(FastForest const& ff, GridForest& grid, std::size_t maxBytes, std::size_t* required) {
+    int nFeatures = 0;
+    for (std::size_t i = 0; i < ff.cutIndices_.size(); ++i) {
+        nFeatures = std::max(nFeatures, static_cast<int>(ff.cutIndices_[i]) + 1);
+    }
+    std::vector<std::vector<FeatureType> > featureThresholds(nFeatures);
+    for (std::size_t i = 0; i < ff.cutIndices_.size(); ++i) {
+        featureThresholds[ff.cutIndices_[i]].push_back(ff.cutValues_[i]);
+    }
+
+    GridForest result;
+    result.nOutputs_ = ff.nOutputs();
+    result.thresholdOffsets_.push_back(0);
+    // the number of cells is computed in double precision, because it can easily overflow for larger models
+    double nCells = 1.;
+    for (int i = 0; i < nFeatures; ++i) {
+        std::vector<FeatureType>& thresholds = featureThresholds[i];
+        if (thresholds.empty()) {
+            continue;
+        }
+        std::sort(thresholds.begin(), thresholds.end());
+        thresholds.erase(std::unique(thresholds.begin(), thresholds.end()), thresholds.end());
+        result.features_.push_back(i);
+        result.thresholds_.insert(result.thresholds_.end(), thresholds.begin(), thresholds.end());
+        result.thresholdOffsets_.push_back(result.thresholds_.size());
+        nCells *= thresholds.size() + 1;
+    }
+
+    const double nBytes = nCells * result.nOutputs_ * sizeof(TreeEnsembleResponseType) +
+                          result.thresholds_.size() * sizeof(FeatureType) +
+                          result.features_.size() * (sizeof(int) * 2 + sizeof(std::size_t));
+    const double maxSize = static_cast<double>(std::numeric_limits<std::size_t>::max());
+    if (required) {
+        *required = nBytes < maxSize ? static_cast<std::size_t>(nBytes) : std::numeric_limits<std::size_t>::max();
+    }
+    if (nBytes > static_cast<double>(maxBytes)) {
+        return false;
+    }
+
+    // The table is stored with the last axis changing fastest
+    const int nAxes = result.features_.size();
+    result.strides_.resize(nAxes);
+    std::size_t stride = 1;
+    for (int iAxis = nAxes - 1; iAxis >= 0; --iAxis) {
+        result.strides_[iAxis] = stride;
+        stride *= result.thresholdOffsets_[iAxis + 1] - result.thresholdOffsets_[iAxis] + 1;
+    }
+    const std::size_t nTableCells = stride;
+    result.table_.resize(nTableCells * result.nOutputs_);
+
+    // Each cell is evaluated at a representative point. The lowest cell of an axis contains all values below the
+    // first threshold, which all take the same branches as -infinity. Every other cell starts at a threshold and
+    // extends up to the next one, so the threshold itself is a point of the cell.
+    std::vector<int> cell(nAxes, 0);
+    std::vector<FeatureType> rows(static_cast<std::size_t>(cellsPerBlock) * nFeatures, 0.f);
+    for (std::size_t blockBegin = 0; blockBegin < nTableCells; blockBegin += cellsPerBlock) {
+        const int nBlockCells = std::min(nTableCells - blockBegin, static_cast<std::size_t>(cellsPerBlock));
+        for (int iCell = 0; iCell < nBlockCells; ++iCell) {
+            FeatureType* row = &rows[static_cast<std::size_t>(iCell) * nFeatures];
+            for (int iAxis = 0; iAxis < nAxes; ++iAxis) {
+                const int offset = result.thresholdOffsets_[iAxis];
+                row[result.features_[iAxis]] = cell[iAxis] == 0 ? -std::numeric_limits<FeatureType>::infinity()
+                                                                : result.thresholds_[offset + cell[iAxis] - 1];
+            }
+            // advance to the next cell like an odometer
+            for (int iAxis = nAxes - 1; iAxis >= 0; --iAxis) {
+                if (++cell[iAxis] <= result.thresholdOffsets_[iAxis + 1] - result.thresholdOffsets_[iAxis]) {
+                    break;
+                }
+                cell[iAxis] = 0;
+            }
+        }
+        ff.predict(rows.data(), nBlockCells, nFeatures, &result.table_[blockBegin * result.nOutputs_]);
+    }
+
+    std::swap(grid, result);
+    return true;
+}
+
+std::size_t fastforest::GridForest::cellIndex(const FeatureType* array) const {
+    std::size_t index = 0;
+    for (std::size_t iAxis = 0; iAxis < features_.size(); ++iAxis) {
+        const FeatureType* begin = &thresholds_[thresholdOffsets_[iAxis]];
+        const FeatureType* end = &thresholds_[0] + thresholdOffsets_[iAxis + 1];
+        // the number of thresholds that are not larger than the value, which is the cell along this axis
+        index += (std::upper_bound(begin, end, array[features_[iAxis]]) - begin) * strides_[iAxis];
+    }
+    return index * nOutputs_;
+}
+
+void fastforest::GridForest::evaluate(const FeatureType* array, TreeEnsembleResponseType* out) const {
+    const TreeEnsembleResponseType* cell = &table_[cellIndex(array)];
+    std::copy(cell, cell + nOutputs_, out);
+}
+
+std::vector<TreeEnsembleResponseType> fastforest::GridForest::softmax(const FeatureType* array) const {
+    std::vector<TreeEnsembleResponseType> out(nClasses());
+    softmax(array, out.data());
+    return out;
+}
+
+void fastforest::GridForest::softmax(const FeatureType* array, TreeEnsembleResponseType* out) const {
+    if (nClasses() <= 2) {
+        throw std::runtime_error(
+            "Error in GridForest::softmax : binary classification models don't support softmax evaluation.");
+    }
+    evaluate(array, out);
+    fastforest::details::softmaxTransformInplace(out, nClasses());
+}
+
+void fastforest::GridForest::predict(const FeatureType* array,
+                                     int nRows,
+                                     int rowStride,
+                                     TreeEnsembleResponseType* out) const {
+    for (int i = 0; i < nRows; ++i) {
+        evaluate(array + static_cast<std::size_t>(i) * rowStride, out + static_cast<std::size_t>(i) * nOutputs_);
+    }
+}
+
+std::size_t fastforest::GridForest::size() const {
+    return table_.size() * sizeof(TreeEnsembleResponseType) + thresholds_.size() * sizeof(FeatureType) +
+           features_.size() * (sizeof(int) * 2 + sizeof(std::size_t));
+}
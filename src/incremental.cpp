@@ -0,0 +1,139 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+#include "common_details.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace fastforest;
+
+fastforest::IncrementalForest::IncrementalForest(FastForest const& ff) : forest_(ff) {
+    // The cut indices used by each tree, found by walking through its nodes. Nodes can be shared between trees after
+    // fastforest::compress, so the nodes are not simply assigned to the tree of their root.
+    std::vector<std::vector<int> > treeFeatures(forest_.nTrees());
+    std::vector<int> stack;
+    int nFeatures = 0;
+    for (int iTree = 0; iTree < forest_.nTrees(); ++iTree) {
+        std::vector<int>& features = treeFeatures[iTree];
+        stack.assign(1, forest_.rootIndices_[iTree]);
+        while (!stack.empty()) {
+            const int index = stack.back();
+            stack.pop_back();
+            features.push_back(forest_.cutIndices_[index]);
+            if (forest_.leftIndices_[index] > 0) {
+                stack.push_back(forest_.leftIndices_[index]);
+            }
+            if (forest_.rightIndices_[index] > 0) {
+                stack.push_back(forest_.rightIndices_[index]);
+            }
+        }
+        std::sort(features.begin(), features.end());
+        features.erase(std::unique(features.begin(), features.end()), features.end());
+        if (!features.empty()) {
+            nFeatures = std::max(nFeatures, features.back() + 1);
+        }
+    }
+
+    // counting sort of the (feature, tree) pairs, which keeps the trees of each feature in increasing order
+    featureOffsets_.assign(nFeatures + 1, 0);
+    for (std::size_t iTree = 0; iTree < treeFeatures.size(); ++iTree) {
+        for (std::size_t j = 0; j < treeFeatures[iTree].size(); ++j) {
+            ++featureOffsets_[treeFeatures[iTree][j] + 1];
+        }
+    }
+    for (int i = 0; i < nFeatures; ++i) {
+        featureOffsets_[i + 1] += featureOffsets_[i];
+    }
+    featureTrees_.resize(featureOffsets_.back());
+    std::vector<int> positions(featureOffsets_.begin(), featureOffsets_.end() - 1);
+    for (std::size_t iTree = 0; iTree < treeFeatures.size(); ++iTree) {
+        for (std::size_t j = 0; j < treeFeatures[iTree].size(); ++j) {
+            featureTrees_[positions[treeFeatures[iTree][j]]++] = iTree;
+        }
+    }
+}
+
+int fastforest::IncrementalForest::nTreesUsing(int feature) const {
+    if (feature < 0 || feature + 1 >= static_cast<int>(featureOffsets_.size())) {
+        return 0;
+    }
+    return featureOffsets_[feature + 1] - featureOffsets_[feature];
+}
+
+const int* fastforest::IncrementalForest::treesUsing(int feature) const {
+    return nTreesUsing(feature) > 0 ? &featureTrees_[featureOffsets_[feature]] : NULL;
+}
+
+void fastforest::IncrementalForest::evaluate(const FeatureType* array,
+                                             TreeResponseType* treeValues,
+                                             TreeEnsembleResponseType* out) const {
+    const int nOut = forest_.nOutputs();
+    for (int i = 0; i < nOut; ++i) {
+        out[i] = forest_.baseResponses_[i];
+    }
+    for (int iTree = 0; iTree < forest_.nTrees(); ++iTree) {
+        treeValues[iTree] = forest_.responses_[detail::evaluateTree(forest_, forest_.rootIndices_[iTree], array)];
+        out[forest_.treeNumbers_[iTree] % nOut] += treeValues[iTree];
+    }
+}
+
+int fastforest::IncrementalForest::update(const FeatureType* array,
+                                          const int* changedFeatures,
+                                          int nChanged,
+                                          TreeResponseType* treeValues,
+                                          TreeEnsembleResponseType* out) const {
+    const int* trees = NULL;
+    int nAffected = 0;
+    // a tree that splits on several of the changed features must only be evaluated once
+    std::vector<int> merged;
+    if (nChanged == 1) {
+        trees = treesUsing(changedFeatures[0]);
+        nAffected = nTreesUsing(changedFeatures[0]);
+    } else if (nChanged > 1) {
+        for (int i = 0; i < nChanged; ++i) {
+            const int* begin = treesUsing(changedFeatures[i]);
+            merged.insert(merged.end(), begin, begin + nTreesUsing(changedFeatures[i]));
+        }
+        std::sort(merged.begin(), merged.end());
+        merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+        trees = merged.data();
+        nAffected = merged.size();
+    }
+
+    const int nOut = forest_.nOutputs();
+    for (int i = 0; i < nAffected; ++i) {
+        const int iTree = trees[i];
+        const TreeResponseType value =
+            forest_.responses_[detail::evaluateTree(forest_, forest_.rootIndices_[iTree], array)];
+        if (value != treeValues[iTree]) {
+            out[forest_.treeNumbers_[iTree] % nOut] += value - treeValues[iTree];
+            treeValues[iTree] = value;
+        }
+    }
+    return nAffected;
+}
@@ -0,0 +1,282 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define FASTFOREST_JIT_X86_64
+#include <sys/mman.h>
+#endif
+
+using namespace fastforest;
+
+namespace {
+
+    // the generated function writes the raw scores of a row to out
+    typedef void (*CompiledForest)(const FeatureType* array, TreeEnsembleResponseType* out);
+
+#ifdef FASTFOREST_JIT_X86_64
+
+    // Generates the machine code for a forest, following the System V calling convention with the row pointer in rdi
+    // and the output pointer in rsi. The score of a binary classification model is accumulated in xmm0, while the
+    // scores of multiple classes are accumulated in the output array. Within a tree, each node is emitted only once,
+    // so nodes that are shared after fastforest::compress are reached with a jump.
+    class CodeEmitter {
+      public:
+        explicit CodeEmitter(FastForest const& ff)
+            : ff_(ff), nOut_(ff.nOutputs()), emittedIn_(ff.cutIndices_.size(), -1), offsets_(ff.cutIndices_.size()) {}
+
+        std::vector<unsigned char> const& code() const { return code_; }
+
+        void emitForest() {
+            if (nOut_ == 1) {
+                emitLoadFloat(0, ff_.baseResponses_[0]);
+            } else {
+                for (int i = 0; i < nOut_; ++i) {
+                    // mov dword [rsi + disp32], imm32
+                    emitBytes(0xC7, 0x86);
+                    emit32(4 * i);
+                    emitFloat(ff_.baseResponses_[i]);
+                }
+            }
+            for (int iTree = 0; iTree < ff_.nTrees(); ++iTree) {
+                treeEndJumps_.clear();
+                emitNode(ff_.rootIndices_[iTree], iTree);
+                for (std::size_t i = 0; i < treeEndJumps_.size(); ++i) {
+                    patchJump(treeEndJumps_[i], code_.size());
+                }
+            }
+            if (nOut_ == 1) {
+                // movss [rsi], xmm0
+                emitBytes(0xF3, 0x0F, 0x11, 0x06);
+            }
+            // ret
+            emitBytes(0xC3);
+        }
+
+      private:
+        void emitNode(int index, int iTree) {
+            emittedIn_[index] = iTree;
+            offsets_[index] = code_.size();
+            // movss xmm1, [rdi + disp32]
+            emitBytes(0xF3, 0x0F, 0x10, 0x8F);
+            emit32(4 * ff_.cutIndices_[index]);
+            emitLoadFloat(2, ff_.cutValues_[index]);
+            // ucomiss xmm2, xmm1, followed by jbe to the right child, which is also taken for NaN like in the
+            // tree traversal, because the comparison is unordered
+            emitBytes(0x0F, 0x2E, 0xD1);
+            emitBytes(0x0F, 0x86);
+            const std::size_t rightJump = code_.size();
+            emit32(0);
+            emitChild(ff_.leftIndices_[index], iTree);
+            patchJump(rightJump, code_.size());
+            emitChild(ff_.rightIndices_[index], iTree);
+        }
+
+        void emitChild(int index, int iTree) {
+            if (index <= 0) {
+                emitLeaf(-index, iTree);
+            } else if (emittedIn_[index] == iTree) {
+                // jmp rel32
+                emitBytes(0xE9);
+                emit32(0);
+                patchJump(code_.size() - 4, offsets_[index]);
+            } else {
+                emitNode(index, iTree);
+            }
+        }
+
+        void emitLeaf(int leaf, int iTree) {
+            emitLoadFloat(1, ff_.responses_[leaf]);
+            if (nOut_ == 1) {
+                // addss xmm0, xmm1
+                emitBytes(0xF3, 0x0F, 0x58, 0xC1);
+            } else {
+                const int disp = 4 * (ff_.treeNumbers_[iTree] % nOut_);
+                // movss xmm2, [rsi + disp32]
+                emitBytes(0xF3, 0x0F, 0x10, 0x96);
+                emit32(disp);
+                // addss xmm2, xmm1
+                emitBytes(0xF3, 0x0F, 0x58, 0xD1);
+                // movss [rsi + disp32], xmm2
+                emitBytes(0xF3, 0x0F, 0x11, 0x96);
+                emit32(disp);
+            }
+            // jmp rel32 to the end of the tree
+            emitBytes(0xE9);
+            treeEndJumps_.push_back(code_.size());
+            emit32(0);
+        }
+
+        // mov eax, imm32 and movd xmm<reg>, eax
+        void emitLoadFloat(int reg, float value) {
+            emitBytes(0xB8);
+            emitFloat(value);
+            emitBytes(0x66, 0x0F, 0x6E, 0xC0 | (reg << 3));
+        }
+
+        void emitFloat(float value) {
+            unsigned int bits;
+            std::memcpy(&bits, &value, sizeof(float));
+            emit32(bits);
+        }
+
+        void emit32(unsigned int value) {
+            for (int i = 0; i < 4; ++i) {
+                code_.push_back((value >> (8 * i)) & 0xFF);
+            }
+        }
+
+        void emitBytes(int b0, int b1 = -1, int b2 = -1, int b3 = -1) {
+            const int bytes[] = {b0, b1, b2, b3};
+            for (int i = 0; i < 4 && bytes[i] >= 0; ++i) {
+                code_.push_back(bytes[i]);
+            }
+        }
+
+        // sets the rel32 operand at position `at` to jump to `target`
+        void patchJump(std::size_t at, std::size_t target) {
+            const int rel = static_cast<int>(target) - static_cast<int>(at + 4);
+            for (int i = 0; i < 4; ++i) {
+                code_[at + i] = (static_cast<unsigned int>(rel) >> (8 * i)) & 0xFF;
+            }
+        }
+
+        FastForest const& ff_;
+        const int nOut_;
+        // the tree in which each node was emitted last, and the position of its code
+        std::vector<int> emittedIn_;
+        std::vector<std::size_t> offsets_;
+        std::vector<std::size_t> treeEndJumps_;
+        std::vector<unsigned char> code_;
+    };
+
+#endif
+
+}  // namespace
+
+fastforest::JitForest::JitForest() : code_(NULL), codeSize_(0) {}
+
+fastforest::JitForest::JitForest(FastForest const& ff) : forest_(ff), code_(NULL), codeSize_(0) { compile(); }
+
+fastforest::JitForest::JitForest(JitForest const& other) : forest_(other.forest_), code_(NULL), codeSize_(0) {
+    compile();
+}
+
+fastforest::JitForest& fastforest::JitForest::operator=(JitForest const& other) {
+    JitForest copy(other);
+    swap(copy);
+    return *this;
+}
+
+fastforest::JitForest::~JitForest() {
+#ifdef FASTFOREST_JIT_X86_64
+    if (code_) {
+        munmap(code_, codeSize_);
+    }
+#endif
+}
+
+void fastforest::JitForest::swap(JitForest& other) {
+    std::swap(forest_, other.forest_);
+    std::swap(code_, other.code_);
+    std::swap(codeSize_, other.codeSize_);
+}
+
+void fastforest::JitForest::compile() {
+#ifdef FASTFOREST_JIT_X86_64
+    if (forest_.baseResponses_.empty()) {
+        return;
+    }
+    CodeEmitter emitter(forest_);
+    emitter.emitForest();
+    std::vector<unsigned char> const& code = emitter.code();
+
+    // The memory is never writable and executable at the same time. If it can't be made executable, for example
+    // because of a security policy, the tree traversal is used instead.
+    void* memory = mmap(NULL, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return;
+    }
+    std::memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, code.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, code.size());
+        return;
+    }
+    code_ = memory;
+    codeSize_ = code.size();
+#endif
+}
+
+void fastforest::JitForest::evaluate(const FeatureType* array, TreeEnsembleResponseType* out) const {
+    if (code_) {
+        // ISO C++ doesn't allow to cast an object pointer to a function pointer, but copying the bits is fine
+        CompiledForest function;
+        std::memcpy(&function, &code_, sizeof(function));
+        function(array, out);
+    } else {
+        forest_.predict(array, 1, 0, out);
+    }
+}
+
+TreeEnsembleResponseType fastforest::JitForest::operator()(const FeatureType* array) const {
+    if (!code_ || nOutputs() != 1) {
+        return forest_(array);
+    }
+    TreeEnsembleResponseType out;
+    evaluate(array, &out);
+    return out;
+}
+
+std::vector<TreeEnsembleResponseType> fastforest::JitForest::softmax(const FeatureType* array) const {
+    std::vector<TreeEnsembleResponseType> out(nClasses());
+    softmax(array, out.data());
+    return out;
+}
+
+void fastforest::JitForest::softmax(const FeatureType* array, TreeEnsembleResponseType* out) const {
+    if (nClasses() <= 2) {
+        throw std::runtime_error(
+            "Error in JitForest::softmax : binary classification models don't support softmax evaluation.");
+    }
+    evaluate(array, out);
+    fastforest::details::softmaxTransformInplace(out, nClasses());
+}
+
+void fastforest::JitForest::predict(const FeatureType* array,
+                                    int nRows,
+                                    int rowStride,
+                                    TreeEnsembleResponseType* out) const {
+    const int nOut = nOutputs();
+    for (int i = 0; i < nRows; ++i) {
+        evaluate(array + static_cast<std::size_t>(i) * rowStride, out + static_cast<std::size_t>(i) * nOut);
+    }
+}
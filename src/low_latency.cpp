@@ -0,0 +1,293 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+#include "common_details.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#if __cplusplus >= 201103L
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <thread>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+#endif
+
+using namespace fastforest;
+
+namespace {
+
+    // Adds the responses of the trees in [begin, end) to out
+    void addTrees(FastForest const& ff, int begin, int end, const FeatureType* array, TreeEnsembleResponseType* out) {
+        const int nOut = ff.baseResponses_.size();
+        for (int iTree = begin; iTree < end; ++iTree) {
+            const int leaf = detail::evaluateTree(ff, ff.rootIndices_[iTree], array);
+            out[nOut == 1 ? 0 : ff.treeNumbers_[iTree] % nOut] += ff.responses_[leaf];
+        }
+    }
+
+    void evaluateSerial(FastForest const& ff, const FeatureType* array, TreeEnsembleResponseType* out) {
+        std::copy(ff.baseResponses_.begin(), ff.baseResponses_.end(), out);
+        addTrees(ff, 0, ff.rootIndices_.size(), array, out);
+    }
+
+#if __cplusplus >= 201103L
+    // Spins for a while when waiting, and then starts yielding the CPU in case there are more threads than CPUs
+    inline void spinWait(int& spins) {
+        if (spins < 4096) {
+            ++spins;
+#if defined(__SSE2__) || defined(_M_X64)
+            _mm_pause();
+#endif
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    const std::size_t cacheLineSize = 64;
+
+    // Before C++17, neither new nor std::allocator respect alignments that are larger than the one of
+    // std::max_align_t, so the cache line aligned objects are allocated with this function
+    void* allocateAligned(std::size_t size) {
+        void* ptr = nullptr;
+#ifdef _WIN32
+        ptr = _aligned_malloc(size, cacheLineSize);
+#else
+        if (posix_memalign(&ptr, cacheLineSize, size) != 0) {
+            ptr = nullptr;
+        }
+#endif
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    void freeAligned(void* ptr) {
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+#endif
+
+}  // namespace
+
+#if __cplusplus >= 201103L
+
+struct fastforest::LowLatencyForest::Workers {
+    // Per-thread state on its own cache line, such that the threads don't invalidate each other's caches
+    struct alignas(64) Slot {
+        // the last generation that this worker has finished
+        std::atomic<unsigned int> done;
+        int begin;
+        int end;
+    };
+
+    Workers(FastForest const& ff, int nThreads, std::vector<int> const& cpus)
+        : forest(ff),
+          nOut(ff.baseResponses_.size()),
+          nSlots(nThreads),
+          slots(static_cast<Slot*>(allocateAligned(nThreads * sizeof(Slot)))),
+          array(nullptr),
+          generation(0),
+          stop(false) {
+        // round the partial sums of each thread up to full cache lines
+        partialStride = (nOut * sizeof(TreeEnsembleResponseType) + 63) / 64 * 64 / sizeof(TreeEnsembleResponseType);
+        partials = static_cast<TreeEnsembleResponseType*>(
+            allocateAligned(nThreads * partialStride * sizeof(TreeEnsembleResponseType)));
+
+        const int nTrees = ff.rootIndices_.size();
+        int begin = 0;
+        for (int i = 0; i < nThreads; ++i) {
+            new (&slots[i]) Slot();
+            slots[i].done.store(0);
+            slots[i].begin = begin;
+            slots[i].end = begin + nTrees / nThreads + (i < nTrees % nThreads ? 1 : 0);
+            begin = slots[i].end;
+        }
+        // the calling thread takes the first range
+        for (int i = 1; i < nThreads; ++i) {
+            std::vector<int> workerCpus;
+            if (!cpus.empty()) {
+                workerCpus.push_back(cpus[(i - 1) % cpus.size()]);
+            }
+            threads.emplace_back(&Workers::run, this, i, workerCpus);
+        }
+    }
+
+    ~Workers() {
+        stop.store(true, std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_release);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        for (int i = 0; i < nSlots; ++i) {
+            slots[i].~Slot();
+        }
+        freeAligned(slots);
+        freeAligned(partials);
+    }
+
+    static void* operator new(std::size_t size) { return allocateAligned(size); }
+    static void operator delete(void* ptr) { freeAligned(ptr); }
+
+    void run(int iSlot, std::vector<int> cpus) {
+        detail::bindToCpus(cpus);
+        Slot& slot = slots[iSlot];
+        TreeEnsembleResponseType* partial = &partials[iSlot * partialStride];
+        unsigned int seen = 0;
+        while (true) {
+            unsigned int current;
+            int spins = 0;
+            while ((current = generation.load(std::memory_order_acquire)) == seen) {
+                spinWait(spins);
+            }
+            seen = current;
+            if (stop.load(std::memory_order_relaxed)) {
+                return;
+            }
+            std::fill(partial, partial + nOut, TreeEnsembleResponseType(0));
+            addTrees(forest, slot.begin, slot.end, array, partial);
+            slot.done.store(current, std::memory_order_release);
+        }
+    }
+
+    void evaluate(const FeatureType* input, TreeEnsembleResponseType* out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        array = input;
+        const unsigned int current = generation.load(std::memory_order_relaxed) + 1;
+        generation.store(current, std::memory_order_release);
+
+        std::copy(forest.baseResponses_.begin(), forest.baseResponses_.end(), out);
+        addTrees(forest, slots[0].begin, slots[0].end, input, out);
+
+        // add the partial sums in a fixed order, to get the same result for the same input every time
+        for (int i = 1; i < nSlots; ++i) {
+            int spins = 0;
+            while (slots[i].done.load(std::memory_order_acquire) != current) {
+                spinWait(spins);
+            }
+            const TreeEnsembleResponseType* partial = &partials[i * partialStride];
+            for (int j = 0; j < nOut; ++j) {
+                out[j] += partial[j];
+            }
+        }
+    }
+
+    FastForest const& forest;
+    const int nOut;
+    int partialStride;
+    const int nSlots;
+    // allocated with allocateAligned, such that each slot is on its own cache line
+    Slot* slots;
+    TreeEnsembleResponseType* partials;
+    std::vector<std::thread> threads;
+    // the row to evaluate, published by incrementing the generation
+    const FeatureType* array;
+    alignas(64) std::atomic<unsigned int> generation;
+    std::atomic<bool> stop;
+    std::mutex mutex;
+};
+
+#else
+
+struct fastforest::LowLatencyForest::Workers {};
+
+#endif
+
+fastforest::LowLatencyForest::LowLatencyForest(FastForest const& ff,
+                                               int nThreads,
+                                               int minTreesPerThread,
+                                               std::vector<int> const& cpus)
+    : forest_(ff), workers_(NULL) {
+#if __cplusplus >= 201103L
+    nThreads = std::min(nThreads, forest_.nTrees() / std::max(minTreesPerThread, 1));
+    if (nThreads > 1) {
+        workers_ = new Workers(forest_, nThreads, cpus);
+    }
+#else
+    (void)nThreads;
+    (void)minTreesPerThread;
+    (void)cpus;
+#endif
+}
+
+fastforest::LowLatencyForest::~LowLatencyForest() { delete workers_; }
+
+int fastforest::LowLatencyForest::nThreads() const {
+#if __cplusplus >= 201103L
+    if (workers_) {
+        return workers_->nSlots;
+    }
+#endif
+    return 1;
+}
+
+void fastforest::LowLatencyForest::evaluate(const FeatureType* array, TreeEnsembleResponseType* out) const {
+#if __cplusplus >= 201103L
+    if (workers_) {
+        workers_->evaluate(array, out);
+        return;
+    }
+#endif
+    evaluateSerial(forest_, array, out);
+}
+
+TreeEnsembleResponseType fastforest::LowLatencyForest::operator()(const FeatureType* array) const {
+    if (forest_.nOutputs() == 1) {
+        TreeEnsembleResponseType out;
+        evaluate(array, &out);
+        return out;
+    }
+    // like FastForest, the sum over all trees for multiclassification models
+    return forest_(array);
+}
+
+std::vector<TreeEnsembleResponseType> fastforest::LowLatencyForest::softmax(const FeatureType* array) const {
+    std::vector<TreeEnsembleResponseType> out(nClasses());
+    softmax(array, out.data());
+    return out;
+}
+
+void fastforest::LowLatencyForest::softmax(const FeatureType* array, TreeEnsembleResponseType* out) const {
+    if (nClasses() <= 2) {
+        throw std::runtime_error(
+            "Error in LowLatencyForest::softmax : binary classification models don't support softmax evaluation.");
+    }
+    evaluate(array, out);
+    fastforest::details::softmaxTransformInplace(out, nClasses());
+}
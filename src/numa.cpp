@@ -0,0 +1,160 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+#include "common_details.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if __cplusplus >= 201103L
+#include <thread>
+#endif
+
+using namespace fastforest;
+
+namespace {
+
+#if __cplusplus >= 201103L
+    // Parses lists like "0-7,16-23" as used for CPUs and nodes in the Linux sysfs
+    std::vector<int> parseList(std::string const& list) {
+        std::vector<int> values;
+        std::stringstream ss(list);
+        std::string range;
+        while (std::getline(ss, range, ',')) {
+            int first = 0;
+            int last = 0;
+            char dash = 0;
+            std::stringstream rangeStream(range);
+            if (!(rangeStream >> first)) {
+                continue;
+            }
+            if (!(rangeStream >> dash >> last)) {
+                last = first;
+            }
+            for (int value = first; value <= last; ++value) {
+                values.push_back(value);
+            }
+        }
+        return values;
+    }
+
+    std::string readLine(std::string const& filename) {
+        std::ifstream file(filename.c_str());
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+
+    // Returns the CPUs of each NUMA node that has any, or an empty vector if the topology is unknown
+    std::vector<std::vector<int> > numaNodeCpus() {
+        std::vector<std::vector<int> > nodes;
+#ifdef __linux__
+        const std::vector<int> nodeIds = parseList(readLine("/sys/devices/system/node/online"));
+        for (std::size_t i = 0; i < nodeIds.size(); ++i) {
+            std::stringstream path;
+            path << "/sys/devices/system/node/node" << nodeIds[i] << "/cpulist";
+            const std::vector<int> cpus = parseList(readLine(path.str()));
+            if (!cpus.empty()) {
+                nodes.push_back(cpus);
+            }
+        }
+#endif
+        return nodes;
+    }
+#endif
+
+    void evaluateRows(ArenaForest const& forest,
+                      const FeatureType* array,
+                      int begin,
+                      int end,
+                      int rowStride,
+                      TreeEnsembleResponseType* out,
+                      int nOut) {
+        for (int iRow = begin; iRow < end; ++iRow) {
+            forest.evaluate(array + static_cast<std::size_t>(iRow) * rowStride,
+                            out + static_cast<std::size_t>(iRow) * nOut);
+        }
+    }
+
+}  // namespace
+
+fastforest::NumaForest::NumaForest(FastForest const& ff) : nOutputs_(ff.baseResponses_.size()) {
+#if __cplusplus >= 201103L
+    nodeCpus_ = numaNodeCpus();
+    if (nodeCpus_.size() > 1) {
+        // each replica is created by a thread on its node, so the memory is first touched there
+        replicas_.resize(nodeCpus_.size());
+        std::vector<std::thread> threads;
+        for (std::size_t iNode = 0; iNode < nodeCpus_.size(); ++iNode) {
+            threads.emplace_back([this, &ff, iNode]() {
+                detail::bindToCpus(nodeCpus_[iNode]);
+                replicas_[iNode] = ArenaForest(ff);
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        return;
+    }
+#endif
+    nodeCpus_.assign(1, std::vector<int>());
+    replicas_.push_back(ArenaForest(ff));
+}
+
+void fastforest::NumaForest::evaluate(const FeatureType* array,
+                                      int nRows,
+                                      int rowStride,
+                                      TreeEnsembleResponseType* out,
+                                      int nThreads) const {
+    if (nThreads > nRows) {
+        nThreads = nRows;
+    }
+#if __cplusplus >= 201103L
+    if (nThreads > 1) {
+        std::vector<std::thread> threads;
+        int begin = 0;
+        for (int iThread = 0; iThread < nThreads; ++iThread) {
+            const int end = begin + nRows / nThreads + (iThread < nRows % nThreads ? 1 : 0);
+            const std::size_t iNode = iThread % replicas_.size();
+            threads.emplace_back([this, iNode, array, begin, end, rowStride, out]() {
+                if (replicas_.size() > 1) {
+                    detail::bindToCpus(nodeCpus_[iNode]);
+                }
+                evaluateRows(replicas_[iNode], array, begin, end, rowStride, out, nOutputs_);
+            });
+            begin = end;
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        return;
+    }
+#endif
+    evaluateRows(replicas_[0], array, 0, nRows, rowStride, out, nOutputs_);
+}
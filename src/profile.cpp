@@ -0,0 +1,233 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace fastforest;
+
+void fastforest::FastForest::profile(const FeatureType* array,
+                                     int nRows,
+                                     int rowStride,
+                                     ForestProfile& profile) const {
+    int nFeatures = 0;
+    for (std::vector<CutIndexType>::const_iterator it = cutIndices_.begin(); it != cutIndices_.end(); ++it) {
+        nFeatures = std::max(nFeatures, static_cast<int>(*it) + 1);
+    }
+
+    // start a new profile if the one passed was empty or recorded for a different forest
+    if (profile.nodeVisits.size() != cutValues_.size() || profile.leafHits.size() != responses_.size() ||
+        profile.treeNodeVisits.size() != rootIndices_.size()) {
+        profile = ForestProfile();
+        profile.nodeVisits.resize(cutValues_.size());
+        profile.leftTaken.resize(cutValues_.size());
+        profile.leafHits.resize(responses_.size());
+        profile.treeNodeVisits.resize(rootIndices_.size());
+    }
+    if (profile.featureAccesses.size() < static_cast<std::size_t>(nFeatures)) {
+        profile.featureAccesses.resize(nFeatures);
+    }
+
+    for (int iRow = 0; iRow < nRows; ++iRow) {
+        const FeatureType* row = array + static_cast<std::size_t>(iRow) * rowStride;
+        for (std::size_t iTree = 0; iTree < rootIndices_.size(); ++iTree) {
+            int index = rootIndices_[iTree];
+            std::size_t nVisited = 0;
+            do {
+                const CutIndexType cutIndex = cutIndices_[index];
+                const bool left = row[cutIndex] < cutValues_[index];
+                ++profile.nodeVisits[index];
+                ++profile.featureAccesses[cutIndex];
+                ++nVisited;
+                if (left) {
+                    ++profile.leftTaken[index];
+                }
+                index = left ? leftIndices_[index] : rightIndices_[index];
+            } while (index > 0);
+            ++profile.leafHits[-index];
+            profile.treeNodeVisits[iTree] += nVisited;
+        }
+    }
+    profile.nRows += nRows;
+}
+
+void fastforest::ForestProfile::write_report(std::ostream& os) const {
+    const double nRowsDouble = nRows > 0 ? nRows : 1;
+
+    std::size_t nVisitsTotal = 0;
+    for (std::size_t i = 0; i < treeNodeVisits.size(); ++i) {
+        nVisitsTotal += treeNodeVisits[i];
+    }
+
+    // A branch is considered predictable if the same direction is taken in at least 90 % of the cases
+    std::size_t nVisitedNodes = 0;
+    std::size_t nPredictableNodes = 0;
+    std::size_t nPredictableVisits = 0;
+    for (std::size_t i = 0; i < nodeVisits.size(); ++i) {
+        if (nodeVisits[i] == 0) {
+            continue;
+        }
+        ++nVisitedNodes;
+        const double leftRatio = double(leftTaken[i]) / nodeVisits[i];
+        if (leftRatio >= 0.9 || leftRatio <= 0.1) {
+            ++nPredictableNodes;
+            nPredictableVisits += nodeVisits[i];
+        }
+    }
+
+    std::size_t nReachedLeaves = 0;
+    for (std::size_t i = 0; i < leafHits.size(); ++i) {
+        nReachedLeaves += leafHits[i] > 0;
+    }
+
+    os << "FastForest profile over " << nRows << " rows\n";
+    os << "  trees                          : " << treeNodeVisits.size() << "\n";
+    os << "  nodes visited per row          : " << nVisitsTotal / nRowsDouble << "\n";
+    os << "  average path depth             : "
+       << (treeNodeVisits.empty() ? 0.0 : nVisitsTotal / nRowsDouble / treeNodeVisits.size()) << "\n";
+    os << "  nodes ever visited             : " << nVisitedNodes << " of " << nodeVisits.size() << "\n";
+    os << "  leaves ever reached            : " << nReachedLeaves << " of " << leafHits.size() << "\n";
+    os << "  predictable branches (>= 90 %) : " << nPredictableNodes << " nodes, "
+       << (nVisitsTotal > 0 ? 100. * nPredictableVisits / nVisitsTotal : 0.0) << " % of visits\n";
+
+    std::size_t maxTree = 0;
+    for (std::size_t i = 1; i < treeNodeVisits.size(); ++i) {
+        if (treeNodeVisits[i] > treeNodeVisits[maxTree]) {
+            maxTree = i;
+        }
+    }
+    if (!treeNodeVisits.empty()) {
+        os << "  deepest average path           : " << treeNodeVisits[maxTree] / nRowsDouble << " in tree " << maxTree
+           << "\n";
+    }
+
+    std::vector<std::pair<std::size_t, std::size_t> > features;
+    for (std::size_t i = 0; i < featureAccesses.size(); ++i) {
+        if (featureAccesses[i] > 0) {
+            features.push_back(std::make_pair(featureAccesses[i], i));
+        }
+    }
+    std::sort(features.rbegin(), features.rend());
+    os << "  features accessed              : " << features.size() << "\n";
+    os << "  feature accesses per row:\n";
+    for (std::size_t i = 0; i < features.size(); ++i) {
+        os << "    feature " << std::setw(6) << features[i].second << " : " << features[i].first / nRowsDouble << " ("
+           << (100. * features[i].first / nVisitsTotal) << " %)\n";
+    }
+}
+
+namespace {
+
+    struct LayoutStackEntry {
+        int index;
+        bool isLeaf;
+        // index of the parent node in the new layout, and whether we are its left child
+        int parent;
+        bool left;
+    };
+
+    LayoutStackEntry makeEntry(int child, int parent, bool left) {
+        LayoutStackEntry entry;
+        entry.index = child > 0 ? child : -child;
+        entry.isLeaf = child <= 0;
+        entry.parent = parent;
+        entry.left = left;
+        return entry;
+    }
+
+}  // namespace
+
+FastForest fastforest::optimize_layout(FastForest const& ff, ForestProfile const& profile) {
+    if (profile.nodeVisits.size() != ff.cutValues_.size() || profile.leafHits.size() != ff.responses_.size() ||
+        profile.treeNodeVisits.size() != ff.rootIndices_.size()) {
+        throw std::runtime_error(
+            "Error in fastforest::optimize_layout : the profile was not recorded with this forest");
+    }
+
+    const bool hasCovers = !ff.nodeCovers_.empty();
+
+    FastForest out;
+    out.treeNumbers_ = ff.treeNumbers_;
+    out.baseResponses_ = ff.baseResponses_;
+    out.cutIndices_.reserve(ff.cutIndices_.size());
+    out.cutValues_.reserve(ff.cutValues_.size());
+    out.leftIndices_.reserve(ff.leftIndices_.size());
+    out.rightIndices_.reserve(ff.rightIndices_.size());
+    out.responses_.reserve(ff.responses_.size());
+
+    std::vector<LayoutStackEntry> stack;
+
+    for (std::size_t iTree = 0; iTree < ff.rootIndices_.size(); ++iTree) {
+        out.rootIndices_.push_back(out.cutValues_.size());
+        stack.push_back(makeEntry(ff.rootIndices_[iTree], -1, false));
+        stack.back().isLeaf = false;  // a root node is never a leaf, even if it has index zero
+
+        // Depth-first traversal that visits the hotter child first, assigning the new indices in visiting order
+        while (!stack.empty()) {
+            const LayoutStackEntry entry = stack.back();
+            stack.pop_back();
+
+            int newChild;
+            if (entry.isLeaf) {
+                newChild = -static_cast<int>(out.responses_.size());
+                out.responses_.push_back(ff.responses_[entry.index]);
+                if (hasCovers) {
+                    out.leafCovers_.push_back(ff.leafCovers_[entry.index]);
+                }
+            } else {
+                newChild = out.cutValues_.size();
+                out.cutIndices_.push_back(ff.cutIndices_[entry.index]);
+                out.cutValues_.push_back(ff.cutValues_[entry.index]);
+                out.leftIndices_.push_back(0);
+                out.rightIndices_.push_back(0);
+                if (hasCovers) {
+                    out.nodeCovers_.push_back(ff.nodeCovers_[entry.index]);
+                }
+
+                const std::size_t visits = profile.nodeVisits[entry.index];
+                const bool leftIsHot = 2 * profile.leftTaken[entry.index] >= visits;
+                const LayoutStackEntry left = makeEntry(ff.leftIndices_[entry.index], newChild, true);
+                const LayoutStackEntry right = makeEntry(ff.rightIndices_[entry.index], newChild, false);
+                // the entry pushed last is visited first
+                stack.push_back(leftIsHot ? right : left);
+                stack.push_back(leftIsHot ? left : right);
+            }
+
+            if (entry.parent >= 0) {
+                (entry.left ? out.leftIndices_ : out.rightIndices_)[entry.parent] = newChild;
+            }
+        }
+    }
+
+    out.prepareLeafIndices();
+    return out;
+}
@@ -0,0 +1,378 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+#include "common_details.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+using namespace fastforest;
+
+namespace {
+
+    // Number of consecutive leaves that share one scale factor in the int8 format. The leaves of a tree are mostly
+    // stored next to each other, so this is similar to a scale per tree, but it also works for forests where leaves
+    // are shared between trees, like after fastforest::compress.
+    const int int8BlockSize = 32;
+
+    unsigned int floatBits(float value) {
+        unsigned int bits;
+        std::memcpy(&bits, &value, sizeof(float));
+        return bits;
+    }
+
+    float bitsToFloat(unsigned int bits) {
+        float value;
+        std::memcpy(&value, &bits, sizeof(float));
+        return value;
+    }
+
+    // Rounds to the nearest integer, with ties to even like the float conversions
+    unsigned int roundToEven(float value) {
+        const float floor = std::floor(value);
+        unsigned int result = static_cast<unsigned int>(floor);
+        const float diff = value - floor;
+        if (diff > 0.5f || (diff == 0.5f && (result & 1))) {
+            ++result;
+        }
+        return result;
+    }
+
+    unsigned short floatToHalf(float value) {
+        unsigned int bits = floatBits(value);
+        const unsigned short sign = (bits >> 16) & 0x8000;
+        bits &= 0x7fffffff;
+        if (bits >= 0x7f800000) {
+            // infinity stays infinity, and NaN stays NaN
+            return sign | 0x7c00 | (bits > 0x7f800000 ? 0x200 : 0);
+        }
+        if (bits >= 0x477ff000) {
+            // 65520 and above round to infinity
+            return sign | 0x7c00;
+        }
+        if (bits < 0x38800000) {
+            // below the smallest normal half 2^-14, in units of the smallest subnormal half 2^-24
+            return sign | roundToEven(bitsToFloat(bits) * 16777216.f);
+        }
+        const unsigned int mantissa = bits & 0x7fffff;
+        unsigned int half = (((bits >> 23) - 112) << 10) | (mantissa >> 13);
+        const unsigned int rest = mantissa & 0x1fff;
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+            // a carry into the exponent is the correct rounding result
+            ++half;
+        }
+        return sign | half;
+    }
+
+    float halfToFloat(unsigned short half) {
+        const unsigned int sign = static_cast<unsigned int>(half & 0x8000) << 16;
+        const unsigned int exponent = (half >> 10) & 0x1f;
+        const unsigned int mantissa = half & 0x3ff;
+        if (exponent == 0x1f) {
+            return bitsToFloat(sign | 0x7f800000 | (mantissa << 13));
+        }
+        if (exponent == 0) {
+            const float value = mantissa * (1.f / 16777216.f);
+            return sign ? -value : value;
+        }
+        return bitsToFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+    }
+
+    unsigned short floatToBFloat(float value) {
+        const unsigned int bits = floatBits(value);
+        if ((bits & 0x7fffffff) > 0x7f800000) {
+            // keep NaN a quiet NaN, rounding could turn it into infinity
+            return (bits >> 16) | 0x40;
+        }
+        return (bits + 0x7fff + ((bits >> 16) & 1)) >> 16;
+    }
+
+    float bfloatToFloat(unsigned short bfloat) { return bitsToFloat(static_cast<unsigned int>(bfloat) << 16); }
+
+    struct HalfDecoder {
+        explicit HalfDecoder(const unsigned short* leaves) : leaves_(leaves) {}
+        TreeResponseType operator()(int leaf) const { return halfToFloat(leaves_[leaf]); }
+        const unsigned short* leaves_;
+    };
+
+    struct BFloatDecoder {
+        explicit BFloatDecoder(const unsigned short* leaves) : leaves_(leaves) {}
+        TreeResponseType operator()(int leaf) const { return bfloatToFloat(leaves_[leaf]); }
+        const unsigned short* leaves_;
+    };
+
+    struct Int8Decoder {
+        Int8Decoder(const signed char* leaves, const float* scales) : leaves_(leaves), scales_(scales) {}
+        TreeResponseType operator()(int leaf) const { return leaves_[leaf] * scales_[leaf / int8BlockSize]; }
+        const signed char* leaves_;
+        const float* scales_;
+    };
+
+    template <class Type_t>
+    const Type_t* dataOrNull(std::vector<Type_t> const& vec) {
+        return vec.empty() ? NULL : &vec[0];
+    }
+
+    // The quantized files start with this tag, followed by the precision, the leaf arrays, and the nodes in the
+    // format of FastForest::write_bin
+    const char quantizedMagic[4] = {'F', 'F', 'Q', '1'};
+
+    template <class Type_t>
+    void writeArray(std::ostream& os, std::vector<Type_t> const& vec) {
+        const int size = vec.size();
+        os.write(reinterpret_cast<const char*>(&size), sizeof(int));
+        os.write(reinterpret_cast<const char*>(dataOrNull(vec)), size * sizeof(Type_t));
+    }
+
+    void readBytes(std::istream& is, void* out, std::size_t size) {
+        if (!is.read(static_cast<char*>(out), size)) {
+            throw std::runtime_error("Error in fastforest::load_quantized_bin : unexpected end of the file");
+        }
+    }
+
+    // Reads the array in chunks, so a corrupted size can't allocate much more memory than the file contains
+    template <class Type_t>
+    void readArray(std::istream& is, std::vector<Type_t>& vec) {
+        int size;
+        readBytes(is, &size, sizeof(int));
+        if (size < 0) {
+            throw std::runtime_error("Error in fastforest::load_quantized_bin : negative array size");
+        }
+        const std::size_t chunkSize = (1 << 20) / sizeof(Type_t);
+        vec.clear();
+        while (vec.size() < static_cast<std::size_t>(size)) {
+            const std::size_t begin = vec.size();
+            vec.resize(begin + std::min(chunkSize, size - begin));
+            readBytes(is, &vec[begin], (vec.size() - begin) * sizeof(Type_t));
+        }
+    }
+
+    std::size_t sizeInBytes(FastForest const& ff) {
+        return ff.rootIndices_.size() * sizeof(int) + ff.cutIndices_.size() * sizeof(CutIndexType) +
+               ff.cutValues_.size() * sizeof(FeatureType) + ff.leftIndices_.size() * sizeof(int) +
+               ff.rightIndices_.size() * sizeof(int) + ff.responses_.size() * sizeof(TreeResponseType) +
+               ff.treeNumbers_.size() * sizeof(int) + ff.baseResponses_.size() * sizeof(TreeEnsembleResponseType);
+    }
+
+}  // namespace
+
+fastforest::QuantizedForest::QuantizedForest(FastForest const& ff, LeafPrecision precision)
+    : precision_(precision), nodes_(ff) {
+    std::vector<TreeResponseType> const& responses = ff.responses_;
+    if (precision == LeafFloat16 || precision == LeafBFloat16) {
+        halfLeaves_.resize(responses.size());
+        for (std::size_t i = 0; i < responses.size(); ++i) {
+            halfLeaves_[i] = precision == LeafFloat16 ? floatToHalf(responses[i]) : floatToBFloat(responses[i]);
+        }
+    } else if (precision == LeafInt8) {
+        int8Leaves_.resize(responses.size());
+        int8Scales_.resize((responses.size() + int8BlockSize - 1) / int8BlockSize);
+        for (std::size_t iBlock = 0; iBlock < int8Scales_.size(); ++iBlock) {
+            const std::size_t begin = iBlock * int8BlockSize;
+            const std::size_t end = std::min(begin + int8BlockSize, responses.size());
+            float maxAbs = 0.f;
+            for (std::size_t i = begin; i < end; ++i) {
+                maxAbs = std::max(maxAbs, std::abs(responses[i]));
+            }
+            const float scale = maxAbs > 0.f ? maxAbs / 127.f : 1.f;
+            int8Scales_[iBlock] = scale;
+            for (std::size_t i = begin; i < end; ++i) {
+                const float scaled = std::min(127.f, std::max(-127.f, responses[i] / scale));
+                int8Leaves_[i] = static_cast<signed char>(scaled < 0 ? -static_cast<int>(roundToEven(-scaled))
+                                                                     : static_cast<int>(roundToEven(scaled)));
+            }
+        }
+    } else {
+        throw std::runtime_error("Error in fastforest::QuantizedForest : unknown leaf precision");
+    }
+
+    nodes_.responses_.clear();
+    nodes_.nodeCovers_.clear();
+    nodes_.leafCovers_.clear();
+}
+
+TreeResponseType fastforest::QuantizedForest::leafValue(int leaf) const {
+    if (precision_ == LeafFloat16) {
+        return halfToFloat(halfLeaves_[leaf]);
+    }
+    if (precision_ == LeafBFloat16) {
+        return bfloatToFloat(halfLeaves_[leaf]);
+    }
+    return Int8Decoder(dataOrNull(int8Leaves_), dataOrNull(int8Scales_))(leaf);
+}
+
+std::size_t fastforest::QuantizedForest::size() const {
+    return sizeInBytes(nodes_) + halfLeaves_.size() * sizeof(unsigned short) +
+           int8Leaves_.size() * sizeof(signed char) + int8Scales_.size() * sizeof(float);
+}
+
+void fastforest::QuantizedForest::write_bin(std::string const& filename) const {
+    std::ofstream os(filename.c_str(), std::ios::binary);
+    if (!os) {
+        throw std::runtime_error("Error in fastforest::QuantizedForest::write_bin : can't open " + filename);
+    }
+    os.write(quantizedMagic, sizeof(quantizedMagic));
+    const int precision = precision_;
+    os.write(reinterpret_cast<const char*>(&precision), sizeof(int));
+    writeArray(os, halfLeaves_);
+    writeArray(os, int8Leaves_);
+    writeArray(os, int8Scales_);
+    detail::writeBin(os, nodes_);
+}
+
+QuantizedForest fastforest::load_quantized_bin(std::string const& filename) {
+    std::ifstream is(filename.c_str(), std::ios::binary);
+    if (!is) {
+        throw std::runtime_error("Error in fastforest::load_quantized_bin : can't open " + filename);
+    }
+    char magic[sizeof(quantizedMagic)];
+    readBytes(is, magic, sizeof(magic));
+    if (std::memcmp(magic, quantizedMagic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Error in fastforest::load_quantized_bin : " + filename +
+                                 " was not written by QuantizedForest::write_bin");
+    }
+    int precision;
+    readBytes(is, &precision, sizeof(int));
+    if (precision != LeafFloat16 && precision != LeafBFloat16 && precision != LeafInt8) {
+        throw std::runtime_error("Error in fastforest::load_quantized_bin : unknown leaf precision");
+    }
+
+    QuantizedForest forest;
+    forest.precision_ = static_cast<LeafPrecision>(precision);
+    readArray(is, forest.halfLeaves_);
+    readArray(is, forest.int8Leaves_);
+    readArray(is, forest.int8Scales_);
+    // the nodes have no leaf values, which load_bin would reject
+    forest.nodes_ = detail::readBin(is);
+
+    // the leaf arrays are stored separately from the nodes, so check that they fit together
+    const bool isInt8 = forest.precision_ == LeafInt8;
+    const std::size_t nLeaves = isInt8 ? forest.int8Leaves_.size() : forest.halfLeaves_.size();
+    const std::size_t nScales = isInt8 ? (nLeaves + int8BlockSize - 1) / int8BlockSize : 0;
+    const bool otherEmpty = isInt8 ? forest.halfLeaves_.empty() : forest.int8Leaves_.empty();
+    std::vector<int> firstLeaves;
+    int maxLeavesPerTree;
+    if (!otherEmpty || forest.int8Scales_.size() != nScales ||
+        !detail::findFirstLeaves(forest.nodes_, nLeaves, firstLeaves, maxLeavesPerTree)) {
+        throw std::runtime_error("Error in fastforest::load_quantized_bin : the leaves don't match the nodes");
+    }
+    return forest;
+}
+
+template <class Decoder_t>
+void fastforest::QuantizedForest::evaluate(Decoder_t const& decoder,
+                                           const FeatureType* array,
+                                           TreeEnsembleResponseType* out) const {
+    const int nOut = nodes_.baseResponses_.size();
+    for (int i = 0; i < nOut; ++i) {
+        out[i] = nodes_.baseResponses_[i];
+    }
+    const int nTrees = nodes_.rootIndices_.size();
+    for (int iTree = 0; iTree < nTrees; ++iTree) {
+        const int leaf = detail::evaluateTree(nodes_, nodes_.rootIndices_[iTree], array);
+        out[nOut == 1 ? 0 : nodes_.treeNumbers_[iTree] % nOut] += decoder(leaf);
+    }
+}
+
+void fastforest::QuantizedForest::evaluate(const FeatureType* array, TreeEnsembleResponseType* out) const {
+    if (precision_ == LeafFloat16) {
+        evaluate(HalfDecoder(dataOrNull(halfLeaves_)), array, out);
+    } else if (precision_ == LeafBFloat16) {
+        evaluate(BFloatDecoder(dataOrNull(halfLeaves_)), array, out);
+    } else {
+        evaluate(Int8Decoder(dataOrNull(int8Leaves_), dataOrNull(int8Scales_)), array, out);
+    }
+}
+
+TreeEnsembleResponseType fastforest::QuantizedForest::operator()(const FeatureType* array) const {
+    TreeEnsembleResponseType out = nodes_.baseResponses_[0];
+    for (int iTree = 0; iTree < nTrees(); ++iTree) {
+        out += leafValue(detail::evaluateTree(nodes_, nodes_.rootIndices_[iTree], array));
+    }
+    return out;
+}
+
+std::vector<TreeEnsembleResponseType> fastforest::QuantizedForest::softmax(const FeatureType* array) const {
+    std::vector<TreeEnsembleResponseType> out(nClasses());
+    softmax(array, out.data());
+    return out;
+}
+
+void fastforest::QuantizedForest::softmax(const FeatureType* array, TreeEnsembleResponseType* out) const {
+    if (nClasses() <= 2) {
+        throw std::runtime_error(
+            "Error in QuantizedForest::softmax : binary classification models don't support softmax evaluation.");
+    }
+    evaluate(array, out);
+    fastforest::details::softmaxTransformInplace(out, nClasses());
+}
+
+void fastforest::QuantizedForest::predict(const FeatureType* array,
+                                          int nRows,
+                                          int rowStride,
+                                          TreeEnsembleResponseType* out) const {
+    const int nOut = nOutputs();
+    for (int i = 0; i < nRows; ++i) {
+        evaluate(array + static_cast<std::size_t>(i) * rowStride, out + static_cast<std::size_t>(i) * nOut);
+    }
+}
+
+QuantizedForest fastforest::quantize(FastForest const& ff,
+                                     LeafPrecision precision,
+                                     const FeatureType* array,
+                                     int nRows,
+                                     int rowStride,
+                                     QuantizationReport* report) {
+    QuantizedForest quantized(ff, precision);
+    if (report) {
+        report->bytesBefore = sizeInBytes(ff);
+        report->bytesAfter = quantized.size();
+        report->maxLeafError = 0.;
+        for (std::size_t i = 0; i < ff.responses_.size(); ++i) {
+            const double error = std::abs(static_cast<double>(quantized.leafValue(i)) - ff.responses_[i]);
+            report->maxLeafError = std::max(report->maxLeafError, error);
+        }
+        report->maxPredictionError = 0.;
+        const int nOut = ff.nOutputs();
+        std::vector<TreeEnsembleResponseType> reference(nOut);
+        std::vector<TreeEnsembleResponseType> scores(nOut);
+        for (int i = 0; i < nRows; ++i) {
+            const FeatureType* row = array + static_cast<std::size_t>(i) * rowStride;
+            ff.predict(row, 1, rowStride, reference.data());
+            quantized.evaluate(row, scores.data());
+            for (int j = 0; j < nOut; ++j) {
+                const double error = std::abs(static_cast<double>(scores[j]) - reference[j]);
+                report->maxPredictionError = std::max(report->maxPredictionError, error);
+            }
+        }
+    }
+    return quantized;
+}
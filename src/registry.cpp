@@ -0,0 +1,161 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+#include "common_details.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace fastforest;
+
+namespace {
+
+    // Evaluates one forest on one row, adding the responses to the base responses like FastForest::evaluate
+    inline void evaluateForest(FastForest const& ff, const FeatureType* row, TreeEnsembleResponseType* out) {
+        const int nOut = ff.baseResponses_.size();
+        for (int i = 0; i < nOut; ++i) {
+            out[i] = ff.baseResponses_[i];
+        }
+        const CutIndexType* cutIndices = ff.cutIndices_.data();
+        const FeatureType* cutValues = ff.cutValues_.data();
+        const int* leftIndices = ff.leftIndices_.data();
+        const int* rightIndices = ff.rightIndices_.data();
+        const int nTrees = ff.rootIndices_.size();
+        for (int iTree = 0; iTree < nTrees; ++iTree) {
+            const int leaf =
+                detail::evaluateTree(ff.rootIndices_[iTree], row, cutIndices, cutValues, leftIndices, rightIndices);
+            out[nOut == 1 ? 0 : ff.treeNumbers_[iTree] % nOut] += ff.responses_[leaf];
+        }
+    }
+
+    struct LoadContext {
+        std::vector<std::string> const* txtpaths;
+        int nClasses;
+        std::vector<FastForest>* forests;
+        std::vector<std::vector<std::string> >* features;
+        // the messages of exceptions that were thrown while loading, because they can't cross the thread boundary
+        std::vector<std::string>* errors;
+    };
+
+    void loadRange(int begin, int end, void* context) {
+        LoadContext const& ctx = *static_cast<LoadContext*>(context);
+        for (int i = begin; i < end; ++i) {
+            try {
+                (*ctx.forests)[i] = fastforest::load_txt((*ctx.txtpaths)[i], (*ctx.features)[i], ctx.nClasses);
+            } catch (std::exception const& e) {
+                (*ctx.errors)[i] = e.what();
+            }
+        }
+    }
+
+}  // namespace
+
+int fastforest::ForestRegistry::add(FastForest const& ff, std::vector<std::string> const& features) {
+    // validate before touching the feature mapping, so a rejected forest leaves the registry unchanged
+    for (std::vector<CutIndexType>::const_iterator it = ff.cutIndices_.begin(); it != ff.cutIndices_.end(); ++it) {
+        if (*it >= features.size()) {
+            throw std::runtime_error("Error in ForestRegistry::add : the forest uses more features than given names");
+        }
+    }
+    FastForest forest = ff;
+    for (std::vector<CutIndexType>::iterator it = forest.cutIndices_.begin(); it != forest.cutIndices_.end(); ++it) {
+        std::string const& name = features[*it];
+        std::map<std::string, int>::const_iterator found = featureIndices_.find(name);
+        if (found == featureIndices_.end()) {
+            found = featureIndices_.insert(std::make_pair(name, static_cast<int>(features_.size()))).first;
+            features_.push_back(name);
+        }
+        *it = found->second;
+    }
+    outputOffsets_.push_back(nOutputs());
+    forests_.push_back(forest);
+    return forests_.size() - 1;
+}
+
+int fastforest::ForestRegistry::load_txt(std::string const& txtpath, int nClasses) {
+    std::vector<std::string> features;
+    return add(fastforest::load_txt(txtpath, features, nClasses), features);
+}
+
+int fastforest::ForestRegistry::load_txt(std::vector<std::string> const& txtpaths, int nClasses, int nThreads) {
+    std::vector<FastForest> forests(txtpaths.size());
+    std::vector<std::vector<std::string> > features(txtpaths.size());
+    std::vector<std::string> errors(txtpaths.size());
+    LoadContext ctx;
+    ctx.txtpaths = &txtpaths;
+    ctx.nClasses = nClasses;
+    ctx.forests = &forests;
+    ctx.features = &features;
+    ctx.errors = &errors;
+    detail::parallelFor(txtpaths.size(), nThreads, loadRange, &ctx);
+
+    for (std::size_t i = 0; i < errors.size(); ++i) {
+        if (!errors[i].empty()) {
+            throw std::runtime_error(errors[i]);
+        }
+    }
+    const int first = nModels();
+    for (std::size_t i = 0; i < forests.size(); ++i) {
+        add(forests[i], features[i]);
+    }
+    return first;
+}
+
+void fastforest::ForestRegistry::evaluate(const FeatureType* array,
+                                          int nRows,
+                                          int rowStride,
+                                          TreeEnsembleResponseType* out) const {
+    const int nOut = nOutputs();
+    for (int iRow = 0; iRow < nRows; ++iRow) {
+        const FeatureType* row = array + static_cast<std::size_t>(iRow) * rowStride;
+        TreeEnsembleResponseType* rowOut = out + static_cast<std::size_t>(iRow) * nOut;
+        for (std::size_t iModel = 0; iModel < forests_.size(); ++iModel) {
+            evaluateForest(forests_[iModel], row, rowOut + outputOffsets_[iModel]);
+        }
+    }
+}
+
+void fastforest::ForestRegistry::evaluate(const FeatureType* array,
+                                          int nRows,
+                                          int rowStride,
+                                          const int* models,
+                                          int nModels,
+                                          TreeEnsembleResponseType* out) const {
+    int nOut = 0;
+    for (int i = 0; i < nModels; ++i) {
+        nOut += nOutputs(models[i]);
+    }
+    for (int iRow = 0; iRow < nRows; ++iRow) {
+        const FeatureType* row = array + static_cast<std::size_t>(iRow) * rowStride;
+        TreeEnsembleResponseType* rowOut = out + static_cast<std::size_t>(iRow) * nOut;
+        for (int i = 0; i < nModels; ++i) {
+            evaluateForest(forests_[models[i]], row, rowOut);
+            rowOut += nOutputs(models[i]);
+        }
+    }
+}
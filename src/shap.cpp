@@ -0,0 +1,261 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <fastforest.h>
+#include "common_details.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+using namespace fastforest;
+
+// Implementation of the path-dependent TreeSHAP algorithm from Lundberg et al., "Consistent Individualized Feature
+// Attribution for Tree Ensembles", following closely the implementation in the src/tree/tree_model.cc source file of
+// xgboost.
+
+namespace {
+
+    struct PathElement {
+        int featureIndex;
+        double zeroFraction;
+        double oneFraction;
+        double pathWeight;
+    };
+
+    void extendPath(
+        PathElement* uniquePath, int uniqueDepth, double zeroFraction, double oneFraction, int featureIndex) {
+        uniquePath[uniqueDepth].featureIndex = featureIndex;
+        uniquePath[uniqueDepth].zeroFraction = zeroFraction;
+        uniquePath[uniqueDepth].oneFraction = oneFraction;
+        uniquePath[uniqueDepth].pathWeight = uniqueDepth == 0 ? 1.0 : 0.0;
+        for (int i = uniqueDepth - 1; i >= 0; --i) {
+            uniquePath[i + 1].pathWeight += oneFraction * uniquePath[i].pathWeight * (i + 1) / (uniqueDepth + 1);
+            uniquePath[i].pathWeight = zeroFraction * uniquePath[i].pathWeight * (uniqueDepth - i) / (uniqueDepth + 1);
+        }
+    }
+
+    void unwindPath(PathElement* uniquePath, int uniqueDepth, int pathIndex) {
+        const double oneFraction = uniquePath[pathIndex].oneFraction;
+        const double zeroFraction = uniquePath[pathIndex].zeroFraction;
+        double nextOnePortion = uniquePath[uniqueDepth].pathWeight;
+        for (int i = uniqueDepth - 1; i >= 0; --i) {
+            if (oneFraction != 0) {
+                const double tmp = uniquePath[i].pathWeight;
+                uniquePath[i].pathWeight = nextOnePortion * (uniqueDepth + 1) / ((i + 1) * oneFraction);
+                nextOnePortion = tmp - uniquePath[i].pathWeight * zeroFraction * (uniqueDepth - i) / (uniqueDepth + 1);
+            } else {
+                uniquePath[i].pathWeight =
+                    uniquePath[i].pathWeight * (uniqueDepth + 1) / (zeroFraction * (uniqueDepth - i));
+            }
+        }
+        for (int i = pathIndex; i < uniqueDepth; ++i) {
+            uniquePath[i].featureIndex = uniquePath[i + 1].featureIndex;
+            uniquePath[i].zeroFraction = uniquePath[i + 1].zeroFraction;
+            uniquePath[i].oneFraction = uniquePath[i + 1].oneFraction;
+        }
+    }
+
+    // Sum of the path weights if the element at pathIndex was unwound from the path
+    double unwoundPathSum(const PathElement* uniquePath, int uniqueDepth, int pathIndex) {
+        const double oneFraction = uniquePath[pathIndex].oneFraction;
+        const double zeroFraction = uniquePath[pathIndex].zeroFraction;
+        double nextOnePortion = uniquePath[uniqueDepth].pathWeight;
+        double total = 0.0;
+        for (int i = uniqueDepth - 1; i >= 0; --i) {
+            if (oneFraction != 0) {
+                const double tmp = nextOnePortion * (uniqueDepth + 1) / ((i + 1) * oneFraction);
+                total += tmp;
+                nextOnePortion = uniquePath[i].pathWeight - tmp * zeroFraction * (uniqueDepth - i) / (uniqueDepth + 1);
+            } else if (zeroFraction != 0) {
+                total += uniquePath[i].pathWeight / zeroFraction / ((uniqueDepth - i) / double(uniqueDepth + 1));
+            }
+        }
+        return total;
+    }
+
+    struct ContributionsContext {
+        FastForest const* ff;
+        const FeatureType* array;
+        int rowStride;
+        int nFeatures;
+        int nOut;
+        int maxDepth;
+        // expected value of each tree, i.e. the cover-weighted mean of its leaves
+        std::vector<double> treeMeans;
+        TreeEnsembleResponseType* out;
+    };
+
+    // In child indices, values larger than zero refer to nodes and the others to leaves.
+    double childCover(FastForest const& ff, int child) {
+        return child > 0 ? ff.nodeCovers_[child] : ff.leafCovers_[-child];
+    }
+
+    void treeShap(FastForest const& ff,
+                  const FeatureType* row,
+                  double* phi,
+                  int index,
+                  bool isLeaf,
+                  int uniqueDepth,
+                  PathElement* parentUniquePath,
+                  double parentZeroFraction,
+                  double parentOneFraction,
+                  int parentFeatureIndex) {
+        PathElement* uniquePath = parentUniquePath + uniqueDepth + 1;
+        std::copy(parentUniquePath, parentUniquePath + uniqueDepth + 1, uniquePath);
+        extendPath(uniquePath, uniqueDepth, parentZeroFraction, parentOneFraction, parentFeatureIndex);
+
+        if (isLeaf) {
+            const double leafValue = ff.responses_[index];
+            for (int i = 1; i <= uniqueDepth; ++i) {
+                const double w = unwoundPathSum(uniquePath, uniqueDepth, i);
+                PathElement const& el = uniquePath[i];
+                phi[el.featureIndex] += w * (el.oneFraction - el.zeroFraction) * leafValue;
+            }
+            return;
+        }
+
+        const int splitIndex = ff.cutIndices_[index];
+        const bool goLeft = row[splitIndex] < ff.cutValues_[index];
+        const int hotChild = goLeft ? ff.leftIndices_[index] : ff.rightIndices_[index];
+        const int coldChild = goLeft ? ff.rightIndices_[index] : ff.leftIndices_[index];
+        const double w = ff.nodeCovers_[index];
+        const double hotZeroFraction = childCover(ff, hotChild) / w;
+        const double coldZeroFraction = childCover(ff, coldChild) / w;
+        double incomingZeroFraction = 1.0;
+        double incomingOneFraction = 1.0;
+
+        // see if we have already split on this feature, if so we undo that split so we can redo it for this node
+        int pathIndex = 0;
+        for (; pathIndex <= uniqueDepth; ++pathIndex) {
+            if (uniquePath[pathIndex].featureIndex == splitIndex) {
+                break;
+            }
+        }
+        if (pathIndex != uniqueDepth + 1) {
+            incomingZeroFraction = uniquePath[pathIndex].zeroFraction;
+            incomingOneFraction = uniquePath[pathIndex].oneFraction;
+            unwindPath(uniquePath, uniqueDepth, pathIndex);
+            uniqueDepth -= 1;
+        }
+
+        treeShap(ff,
+                 row,
+                 phi,
+                 hotChild > 0 ? hotChild : -hotChild,
+                 hotChild <= 0,
+                 uniqueDepth + 1,
+                 uniquePath,
+                 hotZeroFraction * incomingZeroFraction,
+                 incomingOneFraction,
+                 splitIndex);
+        treeShap(ff,
+                 row,
+                 phi,
+                 coldChild > 0 ? coldChild : -coldChild,
+                 coldChild <= 0,
+                 uniqueDepth + 1,
+                 uniquePath,
+                 coldZeroFraction * incomingZeroFraction,
+                 0.0,
+                 splitIndex);
+    }
+
+    // Returns the cover-weighted mean of the leaves below a node, and updates the maximum depth
+    double meanValue(FastForest const& ff, int index, bool isLeaf, int depth, int& maxDepth) {
+        maxDepth = std::max(maxDepth, depth);
+        if (isLeaf) {
+            return ff.responses_[index];
+        }
+        const int left = ff.leftIndices_[index];
+        const int right = ff.rightIndices_[index];
+        return (childCover(ff, left) * meanValue(ff, left > 0 ? left : -left, left <= 0, depth + 1, maxDepth) +
+                childCover(ff, right) * meanValue(ff, right > 0 ? right : -right, right <= 0, depth + 1, maxDepth)) /
+               ff.nodeCovers_[index];
+    }
+
+    void contributionsRange(int begin, int end, void* context) {
+        ContributionsContext const& ctx = *static_cast<ContributionsContext*>(context);
+        FastForest const& ff = *ctx.ff;
+
+        const int nOutPerClass = ctx.nFeatures + 1;
+        const int maxd = ctx.maxDepth + 2;
+        std::vector<PathElement> uniquePathData((maxd * (maxd + 1)) / 2);
+        std::vector<double> phi(ctx.nOut * nOutPerClass);
+
+        for (int iRow = begin; iRow < end; ++iRow) {
+            const FeatureType* row = ctx.array + static_cast<std::size_t>(iRow) * ctx.rowStride;
+            for (int iClass = 0; iClass < ctx.nOut; ++iClass) {
+                phi[iClass * nOutPerClass + ctx.nFeatures] = ff.baseResponses_[iClass];
+            }
+            for (std::size_t iTree = 0; iTree < ff.rootIndices_.size(); ++iTree) {
+                double* treePhi = &phi[(ff.treeNumbers_[iTree] % ctx.nOut) * nOutPerClass];
+                treePhi[ctx.nFeatures] += ctx.treeMeans[iTree];
+                treeShap(ff, row, treePhi, ff.rootIndices_[iTree], false, 0, &uniquePathData[0], 1.0, 1.0, -1);
+            }
+            TreeEnsembleResponseType* rowOut = ctx.out + static_cast<std::size_t>(iRow) * phi.size();
+            for (std::size_t i = 0; i < phi.size(); ++i) {
+                rowOut[i] = phi[i];
+                phi[i] = 0.0;
+            }
+        }
+    }
+
+}  // namespace
+
+void fastforest::FastForest::predictContributions(const FeatureType* array,
+                                                  int nRows,
+                                                  int rowStride,
+                                                  int nFeatures,
+                                                  TreeEnsembleResponseType* out,
+                                                  int nThreads) const {
+    if (nodeCovers_.size() != cutValues_.size() || leafCovers_.size() != responses_.size()) {
+        throw std::runtime_error(
+            "Error in FastForest::predictContributions : the forest has no cover statistics. Please dump the model "
+            "with `with_stats=True` to compute feature contributions.");
+    }
+    for (std::vector<CutIndexType>::const_iterator it = cutIndices_.begin(); it != cutIndices_.end(); ++it) {
+        if (static_cast<int>(*it) >= nFeatures) {
+            throw std::runtime_error(
+                "Error in FastForest::predictContributions : the forest uses more features than nFeatures.");
+        }
+    }
+
+    ContributionsContext ctx;
+    ctx.ff = this;
+    ctx.array = array;
+    ctx.rowStride = rowStride;
+    ctx.nFeatures = nFeatures;
+    ctx.nOut = baseResponses_.size();
+    ctx.maxDepth = 0;
+    ctx.out = out;
+    ctx.treeMeans.resize(rootIndices_.size());
+    for (std::size_t iTree = 0; iTree < rootIndices_.size(); ++iTree) {
+        ctx.treeMeans[iTree] = meanValue(*this, rootIndices_[iTree], false, 0, ctx.maxDepth);
+    }
+
+    detail::parallelFor(nRows, nThreads, contributionsRange, &ctx);
+}
@@ -27,6 +27,7 @@ SOFTWARE.
 #include <fastforest.h>
 #include "common_details.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -228,23 +229,23 @@ namespace tmva {
         std::vector<std::vector<XMLAttributes> > nodes;
     };
 
-    BDTWithXMLAttributes readXMLFile(std::string const& filename);
+    BDTWithXMLAttributes readXMLFile(std::string const& filename, int nThreads);
 
-    BDTWithXMLAttributes readXMLFile(std::string const& filename) {
-        const std::string str = util::readFile(filename.c_str());
-
-        std::size_t pos1 = 0;
+    // Reads the attributes in the characters from begin to end of the file content, which contain only whole trees
+    void readXMLRange(std::string const& str,
+                      std::size_t begin,
+                      std::size_t end,
+                      BDTWithXMLAttributes& bdtXmlAttributes) {
+        std::size_t pos1 = begin;
 
         std::string name;
         std::string value;
 
-        BDTWithXMLAttributes bdtXmlAttributes;
-
         std::vector<XMLAttributes>* currentTree = NULL;
 
         XMLAttributes* attrs = NULL;
 
-        while ((pos1 = str.find('=', pos1)) != std::string::npos) {
+        while ((pos1 = str.find('=', pos1)) != std::string::npos && pos1 < end) {
             std::size_t pos2 = str.rfind(' ', pos1) + 1;
 
             name = str.substr(pos2, pos1 - pos2);
@@ -276,6 +277,54 @@ namespace tmva {
 
             attrs->set(name, value);
         }
+    }
+
+    struct XMLChunksContext {
+        std::string const* str;
+        // the first character of each part of the file, followed by the end of the file
+        std::vector<std::size_t> const* boundaries;
+        std::vector<BDTWithXMLAttributes>* parts;
+    };
+
+    void readXMLChunks(int begin, int end, void* context) {
+        XMLChunksContext const& ctx = *static_cast<XMLChunksContext*>(context);
+        for (int i = begin; i < end; ++i) {
+            readXMLRange(*ctx.str, (*ctx.boundaries)[i], (*ctx.boundaries)[i + 1], (*ctx.parts)[i]);
+        }
+    }
+
+    // The file is split at the <BinaryTree> elements into one part per thread, and the parts are read concurrently
+    BDTWithXMLAttributes readXMLFile(std::string const& filename, int nThreads) {
+        const std::string str = util::readFile(filename.c_str());
+
+        std::vector<std::size_t> treeBegins;
+        std::size_t pos = str.find("<BinaryTree");
+        while (pos != std::string::npos) {
+            treeBegins.push_back(pos);
+            pos = str.find("<BinaryTree", pos + 1);
+        }
+        const int nTrees = treeBegins.size();
+        const int nChunks = std::max(1, std::min(nThreads, nTrees));
+        std::vector<std::size_t> boundaries(1, 0);
+        for (int i = 1; i < nChunks; ++i) {
+            boundaries.push_back(treeBegins[static_cast<long>(nTrees) * i / nChunks]);
+        }
+        boundaries.push_back(str.size());
+
+        std::vector<BDTWithXMLAttributes> parts(nChunks);
+        XMLChunksContext ctx;
+        ctx.str = &str;
+        ctx.boundaries = &boundaries;
+        ctx.parts = &parts;
+        fastforest::detail::parallelFor(nChunks, nThreads, readXMLChunks, &ctx);
+
+        BDTWithXMLAttributes bdtXmlAttributes;
+        for (int i = 0; i < nChunks; ++i) {
+            BDTWithXMLAttributes const& part = parts[i];
+            bdtXmlAttributes.boostWeights.insert(
+                bdtXmlAttributes.boostWeights.end(), part.boostWeights.begin(), part.boostWeights.end());
+            bdtXmlAttributes.nodes.insert(bdtXmlAttributes.nodes.end(), part.nodes.begin(), part.nodes.end());
+        }
 
         if (bdtXmlAttributes.nodes.size() != bdtXmlAttributes.boostWeights.size()) {
             throw std::runtime_error("nodes size and bosstWeights size don't match");
@@ -350,6 +399,18 @@ namespace {
     typedef std::vector<SlowTreeNode> SlowTree;
     typedef std::vector<SlowTree> SlowForest;
 
+    struct SlowTreesContext {
+        std::vector<std::vector<tmva::XMLAttributes> > const* nodes;
+        SlowForest* forest;
+    };
+
+    void getSlowTrees(int begin, int end, void* context) {
+        SlowTreesContext const& ctx = *static_cast<SlowTreesContext*>(context);
+        for (int i = begin; i < end; ++i) {
+            (*ctx.forest)[i] = getSlowTreeNodes((*ctx.nodes)[i]);
+        }
+    }
+
     std::ostream& operator<<(std::ostream& os, SlowTreeNode const& node) {
         for (int i = 0; i < node.depth; ++i) {
             os << "\t";
@@ -431,14 +492,13 @@ namespace fastforest {
         return ff;
     }
 
-    FastForest load_tmva_xml(std::string const& xmlpath, std::vector<std::string>& features) {
-        tmva::BDTWithXMLAttributes tmvaXML = tmva::readXMLFile(xmlpath);
-        std::vector<std::vector<SlowTreeNode> > xgboostForest;
-        for (std::vector<std::vector<tmva::XMLAttributes> >::const_iterator tree = tmvaXML.nodes.begin();
-             tree != tmvaXML.nodes.end();
-             ++tree) {
-            xgboostForest.push_back(getSlowTreeNodes(*tree));
-        }
+    FastForest load_tmva_xml(std::string const& xmlpath, std::vector<std::string>& features, int nThreads) {
+        tmva::BDTWithXMLAttributes tmvaXML = tmva::readXMLFile(xmlpath, nThreads);
+        SlowForest xgboostForest(tmvaXML.nodes.size());
+        SlowTreesContext ctx;
+        ctx.nodes = &tmvaXML.nodes;
+        ctx.forest = &xgboostForest;
+        detail::parallelFor(xgboostForest.size(), nThreads, getSlowTrees, &ctx);
         return fastforest::load_slowforest(xgboostForest, features);
     }
 }  // namespace fastforest
@@ -47,24 +47,26 @@ def create_test_data(
         model = xgb.XGBClassifier()
         model.load_model(outfile_json)
 
-    outfile = os.path.join(directory, "model.txt")
     booster = model.get_booster()
-    # Dump the model to a .txt file
-    booster.dump_model(outfile, fmap="", with_stats=False, dump_format="text")
-    # Append the base score (unfortunately missing in the .txt dump)
-    with open(outfile, "a") as f:
-        base_score = get_basescore(model)
-        f.write(f"base_score={base_score}\n")
 
-    if int(xgb.__version__[0]) < 2:
-        # Replace all '<' with '<=' in the text dump file (before version 2.0,
-        # XGBoost used inconsistent comparison operators in the model).
+    for with_stats in [False, True]:
+        outfile = os.path.join(directory, "model_with_stats.txt" if with_stats else "model.txt")
+        # Dump the model to a .txt file
+        booster.dump_model(outfile, fmap="", with_stats=with_stats, dump_format="text")
+        # Append the base score (unfortunately missing in the .txt dump)
+        with open(outfile, "a") as f:
+            base_score = get_basescore(model)
+            f.write(f"base_score={base_score}\n")
 
-        with open(outfile, "r") as f:
-            text = f.read()
+        if int(xgb.__version__[0]) < 2:
+            # Replace all '<' with '<=' in the text dump file (before version 2.0,
+            # XGBoost used inconsistent comparison operators in the model).
 
-        with open(outfile, "w") as f:
-            f.write(text.replace("<", "<="))
+            with open(outfile, "r") as f:
+                text = f.read()
+
+            with open(outfile, "w") as f:
+                f.write(text.replace("<", "<="))
 
     if convert_to_tmva:
         import xgboost2tmva
@@ -82,6 +84,10 @@ def create_test_data(
     pd.DataFrame(X_dump).to_csv(os.path.join(directory, "X.csv"), **csv_args)
     pd.DataFrame(preds_dump).to_csv(os.path.join(directory, "preds.csv"), **csv_args)
 
+    # SHAP feature contributions, with the classes concatenated for multiclassification
+    contribs_dump = booster.predict(xgb.DMatrix(X_dump), pred_contribs=True).reshape(len(X_dump), -1)
+    pd.DataFrame(contribs_dump).to_csv(os.path.join(directory, "contribs.csv"), **csv_args)
+
 
 def main():
 
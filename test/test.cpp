@@ -25,11 +25,19 @@ SOFTWARE.
 */
 
 #include <fastforest.h>
+#include <fastforest_c.h>
+#if __cplusplus >= 201103L
+#include <fastforest_batcher.h>
+#include <fastforest_handle.h>
+#endif
 
 #include <gtest/gtest.h>
 
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <cmath>
 #include <sstream>
 
@@ -91,6 +99,40 @@ TEST(FastForest, Basic) {
     }
 }
 
+#ifdef FASTFOREST_SCORE
+TEST(FastForest, ScoreTool) {
+    const std::string tool = FASTFOREST_SCORE;
+
+    const std::string command =
+        tool + " --model continuous/model.txt --input continuous/X.csv --output tool_scores.csv --threads 2";
+    ASSERT_EQ(std::system(command.c_str()), 0);
+
+    std::ifstream fileScores("tool_scores.csv");
+    std::ifstream filePreds("continuous/preds.csv");
+
+    double score;
+    RefPredictionType ref;
+
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        ASSERT_TRUE(fileScores >> score);
+        filePreds >> ref;
+
+        CHECK_CLOSE(score, ref, tolerance);
+    }
+    EXPECT_FALSE(fileScores >> score);
+
+    // binary input that ends in the middle of a row has to be rejected
+    {
+        std::vector<float> truncated(5 * nSamples + 1, 0.f);
+        std::ofstream os("truncated.f32", std::ios::binary);
+        os.write(reinterpret_cast<const char*>(truncated.data()), truncated.size() * sizeof(float));
+    }
+    const std::string truncatedCommand =
+        tool + " --model continuous/model.txt --input truncated.f32 --n-features 5 --output truncated_scores.csv";
+    EXPECT_NE(std::system(truncatedCommand.c_str()), 0);
+}
+#endif
+
 TEST(FastForest, Softmax) {
     std::vector<std::string> features;
     fillFeaturesFive(features);
@@ -148,6 +190,119 @@ TEST(FastForest, SoftmaxNSamples100NFeatures100) {
 
 #if __cplusplus >= 201103L
 
+TEST(FastForest, ForestHandle) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    FF fastForest = fastforest::load_txt("continuous/model.txt", features);
+    FF shifted = fastForest;
+    shifted.baseResponses_[0] += 1.0;
+    shifted.write_bin("continuous/forest_shifted.bin");
+
+    std::vector<fastforest::FeatureType> input{0.0, 0.2, 0.4, 0.6, 0.8};
+    const auto score = fastForest(input.data());
+    const auto shiftedScore = shifted(input.data());
+
+    fastforest::ForestHandle handle(fastForest);
+
+    std::atomic<bool> done{false};
+    std::atomic<int> nWrong{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&]() {
+            while (!done) {
+                auto pinned = handle.pin();
+                const auto x = (*pinned)(input.data());
+                if (x != score && x != shiftedScore) {
+                    ++nWrong;
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        handle.publish(i % 2 == 0 ? shifted : fastForest);
+    }
+    handle.reload_bin_async("continuous/forest_shifted.bin").wait();
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(nWrong, 0);
+    EXPECT_EQ(handle(input.data()), shiftedScore);
+}
+
+TEST(FastForest, MicroBatcher) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    const FF fastForest = fastforest::load_txt("softmax/model.txt", features, 3);
+
+    std::ifstream fileX("softmax/X.csv");
+
+    std::vector<fastforest::FeatureType> input(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+    std::vector<float> ref(3 * nSamples);
+    fastForest.predict(input.data(), nSamples, 5, ref.data());
+
+    std::vector<float> callbackScores(3 * nSamples);
+    std::atomic<int> nCallbacks{0};
+    {
+        fastforest::MicroBatcher batcher(fastForest, 5, 16, std::chrono::microseconds(50), 1, 8);
+        EXPECT_EQ(batcher.nOutputs(), 3);
+
+        // several threads submitting rows concurrently, through a queue that is smaller than the number of rows
+        std::vector<std::thread> threads;
+        for (int iThread = 0; iThread < 4; ++iThread) {
+            threads.emplace_back([&, iThread]() {
+                for (std::size_t i = iThread; i < nSamples; i += 4) {
+                    if (i % 2 == 0) {
+                        std::vector<float> scores = batcher.submit(&input[i * 5]).get();
+                        EXPECT_EQ(scores, std::vector<float>(&ref[i * 3], &ref[i * 3] + 3));
+                    } else {
+                        batcher.submit(&input[i * 5], [&, i](const float* scores) {
+                            std::copy(scores, scores + 3, &callbackScores[i * 3]);
+                            ++nCallbacks;
+                        });
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+    // the destructor has evaluated all remaining rows
+    EXPECT_EQ(nCallbacks.load(), static_cast<int>(nSamples / 2));
+    for (std::size_t i = 1; i < nSamples; i += 2) {
+        for (std::size_t j = 0; j < 3; ++j) {
+            EXPECT_EQ(callbackScores[i * 3 + j], ref[i * 3 + j]);
+        }
+    }
+
+    // with worker threads, and a throwing callback must not affect the other rows of its batch
+    {
+        fastforest::MicroBatcher batcher(fastForest, 5, 16, std::chrono::microseconds(1000), 3);
+        std::vector<std::future<std::vector<float>>> futures;
+        for (std::size_t i = 0; i < nSamples; ++i) {
+            if (i % 3 == 0) {
+                batcher.submit(&input[i * 5], [](const float*) { throw std::runtime_error("callback failed"); });
+            } else {
+                futures.push_back(batcher.submit(&input[i * 5]));
+            }
+        }
+        std::size_t iFuture = 0;
+        for (std::size_t i = 0; i < nSamples; ++i) {
+            if (i % 3 != 0) {
+                EXPECT_EQ(futures[iFuture++].get(), std::vector<float>(&ref[i * 3], &ref[i * 3] + 3));
+            }
+        }
+    }
+}
+
 TEST(FastForest, SoftmaxArray) {
     std::vector<std::string> features;
     fillFeaturesFive(features);
@@ -202,6 +357,997 @@ TEST(FastForest, Serialization) {
     }
 }
 
+TEST(FastForest, CompressedSerialization) {
+    const char* models[] = {"continuous/model.txt", "softmax/model.txt", "manyfeatures/model.txt"};
+    const int nClasses[] = {2, 3, 2};
+
+    for (int iModel = 0; iModel < 3; ++iModel) {
+        std::vector<std::string> features;
+        const FF original = fastforest::load_txt(models[iModel], features, nClasses[iModel]);
+
+        original.write_bin("model.bin");
+        original.write_compressed_bin("model.ffz");
+        std::ifstream binFile("model.bin", std::ios::binary | std::ios::ate);
+        std::ifstream compressedFile("model.ffz", std::ios::binary | std::ios::ate);
+        EXPECT_LT(compressedFile.tellg(), binFile.tellg());
+
+        const FF loaded = fastforest::load_compressed_bin("model.ffz");
+        EXPECT_EQ(loaded.rootIndices_, original.rootIndices_);
+        EXPECT_EQ(loaded.cutIndices_, original.cutIndices_);
+        EXPECT_EQ(loaded.cutValues_, original.cutValues_);
+        EXPECT_EQ(loaded.leftIndices_, original.leftIndices_);
+        EXPECT_EQ(loaded.rightIndices_, original.rightIndices_);
+        EXPECT_EQ(loaded.responses_, original.responses_);
+        EXPECT_EQ(loaded.treeNumbers_, original.treeNumbers_);
+        EXPECT_EQ(loaded.baseResponses_, original.baseResponses_);
+        EXPECT_EQ(loaded.nodeCovers_, original.nodeCovers_);
+        EXPECT_EQ(loaded.leafCovers_, original.leafCovers_);
+    }
+
+    // truncated data and other formats are rejected
+    std::ifstream file("model.ffz", std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_THROW(fastforest::load_compressed_bin(content.data(), content.size() / 2), std::runtime_error);
+    EXPECT_THROW(fastforest::load_compressed_bin("model.bin"), std::runtime_error);
+
+    // a forged header must not make the loader allocate the announced sizes
+    const unsigned char forged[] = {'F', 'F', 'Z', '1', 1, 1, 1, 1, 0, 0xff, 0xff, 0xff, 0xff, 0x0f, 0, 0};
+    EXPECT_THROW(fastforest::load_compressed_bin(forged, sizeof(forged)), std::runtime_error);
+
+    // A child that points back to an ancestor would make the evaluation loop forever, while nodes that are shared
+    // within a tree like after fastforest::compress are fine.
+    std::vector<std::string> features;
+    FF cyclic = fastforest::load_txt("continuous/model.txt", features);
+    fastforest::compress(cyclic).write_compressed_bin("model.ffz");
+    EXPECT_NO_THROW(fastforest::load_compressed_bin("model.ffz"));
+    // index 0 can't be a child, since it would mean the first leaf
+    std::size_t parent = 1;
+    while (cyclic.leftIndices_[parent] <= 0) {
+        ++parent;
+    }
+    cyclic.leftIndices_[cyclic.leftIndices_[parent]] = parent;
+    cyclic.write_compressed_bin("model.ffz");
+    EXPECT_THROW(fastforest::load_compressed_bin("model.ffz"), std::runtime_error);
+}
+
+TEST(FastForest, LoadFromBuffer) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    std::ifstream fileTxt("softmax/model_with_stats.txt");
+    const std::string txt((std::istreambuf_iterator<char>(fileTxt)), std::istreambuf_iterator<char>());
+    std::vector<std::string> bufferFeatures = features;
+    const FF fastForest = fastforest::load_txt(txt.data(), txt.size(), bufferFeatures, 3);
+    const FF reference = fastforest::load_txt("softmax/model_with_stats.txt", features, 3);
+    EXPECT_EQ(fastForest.cutValues_, reference.cutValues_);
+    EXPECT_EQ(fastForest.responses_, reference.responses_);
+    EXPECT_EQ(fastForest.nodeCovers_, reference.nodeCovers_);
+    EXPECT_EQ(fastForest.baseResponses_, reference.baseResponses_);
+
+    fastForest.write_bin("softmax/forest_buffer.bin");
+    std::ifstream fileBin("softmax/forest_buffer.bin", std::ios::binary);
+    const std::string bin((std::istreambuf_iterator<char>(fileBin)), std::istreambuf_iterator<char>());
+
+    const FF binForest = fastforest::load_bin(bin.data(), bin.size());
+    EXPECT_EQ(binForest.leftIndices_, reference.leftIndices_);
+    EXPECT_EQ(binForest.leafCovers_, reference.leafCovers_);
+    EXPECT_THROW(fastforest::load_bin(bin.data(), bin.size() / 2), std::runtime_error);
+    std::istringstream truncatedStream(bin.substr(0, bin.size() / 2));
+    EXPECT_THROW(fastforest::load_bin(truncatedStream), std::runtime_error);
+
+    // array sizes in the header that can't be right are rejected before anything is allocated
+    const int hugeHeader[] = {0x7fffffff, 0, 0};
+    EXPECT_THROW(fastforest::load_bin(hugeHeader, sizeof(hugeHeader)), std::runtime_error);
+    std::istringstream hugeStream(std::string(reinterpret_cast<const char*>(hugeHeader), sizeof(hugeHeader)));
+    EXPECT_THROW(fastforest::load_bin(hugeStream), std::runtime_error);
+    const int negativeHeader[] = {-1, 0, 0};
+    EXPECT_THROW(fastforest::load_bin(negativeHeader, sizeof(negativeHeader)), std::runtime_error);
+
+    // std::string data is suitably aligned, so the arena forest can refer to it without copying
+    const fastforest::ArenaForest view = fastforest::load_arena_bin(bin.data(), bin.size(), false);
+    EXPECT_TRUE(view.isView());
+    EXPECT_EQ(view.data(), bin.data());
+    const fastforest::ArenaForest copied = fastforest::load_arena_bin(bin.data(), bin.size());
+    EXPECT_FALSE(copied.isView());
+    EXPECT_THROW(fastforest::load_arena_bin(bin.data(), 20), std::runtime_error);
+
+    std::ifstream fileX("softmax/X.csv");
+
+    std::vector<fastforest::FeatureType> input(5);
+
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        for (std::size_t j = 0; j < input.size(); ++j) {
+            fileX >> input[j];
+        }
+        std::vector<float> ref = reference.softmax(input.data());
+        EXPECT_EQ(fastForest.softmax(input.data()), ref);
+        EXPECT_EQ(binForest.softmax(input.data()), ref);
+        EXPECT_EQ(view.softmax(input.data()), ref);
+        EXPECT_EQ(copied.softmax(input.data()), ref);
+    }
+}
+
+TEST(FastForest, LoadParallel) {
+    const char* models[] = {"continuous/model.txt", "softmax/model.txt", "manyfeatures/model.txt"};
+    const int nClasses[] = {2, 3, 2};
+
+    for (int iModel = 0; iModel < 3; ++iModel) {
+        std::vector<std::string> features;
+        const FF reference = fastforest::load_txt(models[iModel], features, nClasses[iModel]);
+
+        std::ifstream file(models[iModel]);
+        const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        for (int nThreads = 2; nThreads <= 7; nThreads += 5) {
+            std::vector<std::string> parallelFeatures;
+            const FF fromFile = fastforest::load_txt(models[iModel], parallelFeatures, nClasses[iModel], nThreads);
+            std::vector<std::string> bufferFeatures;
+            const FF fromBuffer =
+                fastforest::load_txt(content.data(), content.size(), bufferFeatures, nClasses[iModel], nThreads);
+
+            EXPECT_EQ(parallelFeatures, features);
+            EXPECT_EQ(bufferFeatures, features);
+            const FF* forests[] = {&fromFile, &fromBuffer};
+            for (int i = 0; i < 2; ++i) {
+                FF const& ff = *forests[i];
+                EXPECT_EQ(ff.rootIndices_, reference.rootIndices_);
+                EXPECT_EQ(ff.cutIndices_, reference.cutIndices_);
+                EXPECT_EQ(ff.cutValues_, reference.cutValues_);
+                EXPECT_EQ(ff.leftIndices_, reference.leftIndices_);
+                EXPECT_EQ(ff.rightIndices_, reference.rightIndices_);
+                EXPECT_EQ(ff.responses_, reference.responses_);
+                EXPECT_EQ(ff.treeNumbers_, reference.treeNumbers_);
+                EXPECT_EQ(ff.baseResponses_, reference.baseResponses_);
+            }
+        }
+    }
+
+    // with a given list of features
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+    std::vector<std::string> parallelFeatures = features;
+    const FF reference = fastforest::load_txt("discrete/model.txt", features);
+    const FF parallel = fastforest::load_txt("discrete/model.txt", parallelFeatures, 2, 3);
+    EXPECT_EQ(parallelFeatures, features);
+    EXPECT_EQ(parallel.cutIndices_, reference.cutIndices_);
+    EXPECT_EQ(parallel.cutValues_, reference.cutValues_);
+
+    // several binary classification models at once into a registry, compared to loading them one by one
+    const char* binaryModels[] = {"continuous/model.txt", "discrete/model.txt", "manyfeatures/model.txt"};
+    fastforest::ForestRegistry registry;
+    fastforest::ForestRegistry serialRegistry;
+    std::vector<std::string> paths(binaryModels, binaryModels + 3);
+    EXPECT_EQ(registry.load_txt(paths, 2, 3), 0);
+    EXPECT_EQ(registry.nModels(), 3);
+    for (int iModel = 0; iModel < 3; ++iModel) {
+        serialRegistry.load_txt(paths[iModel]);
+        FF const& ff = registry.forests_[iModel];
+        FF const& serial = serialRegistry.forests_[iModel];
+        EXPECT_EQ(ff.cutIndices_, serial.cutIndices_);
+        EXPECT_EQ(ff.cutValues_, serial.cutValues_);
+        EXPECT_EQ(ff.leftIndices_, serial.leftIndices_);
+        EXPECT_EQ(ff.responses_, serial.responses_);
+        EXPECT_EQ(ff.baseResponses_, serial.baseResponses_);
+    }
+    EXPECT_EQ(registry.features_, serialRegistry.features_);
+    paths.push_back("does_not_exist.txt");
+    EXPECT_THROW(registry.load_txt(paths, 2, 3), std::runtime_error);
+    EXPECT_EQ(registry.nModels(), 3);
+}
+
+TEST(FastForest, Append) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    std::ifstream file("softmax/model.txt");
+    const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const FF full = fastforest::load_txt(content.data(), content.size(), features, 3);
+
+    // split the dump into the first 30 boosting rounds and the remaining ones, both with the base score
+    std::size_t split = 0;
+    for (int i = 0; i < 90; ++i) {
+        split = content.find("booster[", split + 1);
+    }
+    const std::string baseScore = content.substr(content.find("base_score="));
+    const std::string firstPart = content.substr(0, split) + baseScore;
+    const std::string secondPart = content.substr(split);
+    const FF previous = fastforest::load_txt(firstPart.data(), firstPart.size(), features, 3);
+    const FF rounds = fastforest::load_txt(secondPart.data(), secondPart.size(), features, 3);
+    EXPECT_EQ(previous.nTrees() + rounds.nTrees(), full.nTrees());
+
+    FF appended = previous;
+    appended.append(rounds);
+    EXPECT_EQ(appended.rootIndices_, full.rootIndices_);
+    EXPECT_EQ(appended.leftIndices_, full.leftIndices_);
+    EXPECT_EQ(appended.rightIndices_, full.rightIndices_);
+    EXPECT_EQ(appended.responses_, full.responses_);
+    EXPECT_EQ(appended.baseResponses_, full.baseResponses_);
+    for (int i = 0; i < full.nTrees(); ++i) {
+        EXPECT_EQ(appended.treeNumbers_[i] % 3, full.treeNumbers_[i] % 3);
+    }
+
+    fastforest::write_delta_bin("delta.bin", previous, full);
+    full.write_bin("full.bin");
+    std::ifstream deltaFile("delta.bin", std::ios::binary | std::ios::ate);
+    std::ifstream fullFile("full.bin", std::ios::binary | std::ios::ate);
+    EXPECT_LT(deltaFile.tellg(), fullFile.tellg());
+
+    FF updated = previous;
+    updated.append_delta_bin("delta.bin");
+    EXPECT_EQ(updated.rootIndices_, full.rootIndices_);
+    EXPECT_EQ(updated.cutIndices_, full.cutIndices_);
+    EXPECT_EQ(updated.cutValues_, full.cutValues_);
+    EXPECT_EQ(updated.leftIndices_, full.leftIndices_);
+    EXPECT_EQ(updated.rightIndices_, full.rightIndices_);
+    EXPECT_EQ(updated.responses_, full.responses_);
+    EXPECT_EQ(updated.treeNumbers_, full.treeNumbers_);
+    EXPECT_EQ(updated.baseResponses_, full.baseResponses_);
+
+    // the update can't be applied twice, and not to a different forest with the same numbers of trees and nodes
+    EXPECT_THROW(updated.append_delta_bin("delta.bin"), std::runtime_error);
+    FF sameShape = previous;
+    sameShape.cutValues_[0] += 1.f;
+    EXPECT_THROW(sameShape.append_delta_bin("delta.bin"), std::runtime_error);
+    EXPECT_EQ(sameShape.nTrees(), previous.nTrees());
+    EXPECT_THROW(sameShape.append_delta_bin("full.bin"), std::runtime_error);
+
+    // the previous forest has to be the start of the updated one
+    EXPECT_THROW(fastforest::write_delta_bin("delta.bin", rounds, full), std::runtime_error);
+}
+
+TEST(FastForest, Predict) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    const FF binaryForest = fastforest::load_txt("continuous/model.txt", features);
+    const FF softmaxForest = fastforest::load_txt("softmax/model.txt", features, 3);
+
+    std::ifstream fileX("softmax/X.csv");
+
+    std::vector<fastforest::FeatureType> input(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+
+    std::vector<fastforest::TreeEnsembleResponseType> binaryOut(nSamples);
+    std::vector<fastforest::TreeEnsembleResponseType> softmaxOut(3 * nSamples);
+    binaryForest.predict(input.data(), nSamples, 5, binaryOut.data());
+    softmaxForest.predict(input.data(), nSamples, 5, softmaxOut.data(), 3);
+
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        EXPECT_EQ(binaryOut[i], binaryForest(input.data() + i * 5));
+        fastforest::details::softmaxTransformInplace(&softmaxOut[i * 3], 3);
+        std::vector<float> ref = softmaxForest.softmax(input.data() + i * 5);
+        for (std::size_t j = 0; j < 3; ++j) {
+            EXPECT_EQ(softmaxOut[i * 3 + j], ref[j]);
+        }
+    }
+
+    // accumulation in double precision
+    std::vector<double> binaryOutDouble(nSamples);
+    std::vector<double> softmaxOutDouble(3);
+    binaryForest.predict(input.data(), nSamples, 5, binaryOutDouble.data(), 2);
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        const float* row = input.data() + i * 5;
+        double sum = binaryForest.baseResponses_[0];
+        for (int iTree = 0; iTree < binaryForest.nTrees(); ++iTree) {
+            int index = binaryForest.rootIndices_[iTree];
+            do {
+                const bool left = row[binaryForest.cutIndices_[index]] < binaryForest.cutValues_[index];
+                index = left ? binaryForest.leftIndices_[index] : binaryForest.rightIndices_[index];
+            } while (index > 0);
+            sum += binaryForest.responses_[-index];
+        }
+        EXPECT_EQ(binaryOutDouble[i], sum);
+        EXPECT_NEAR(binaryOutDouble[i], binaryOut[i], 1e-5);
+
+        softmaxForest.softmax(input.data() + i * 5, softmaxOutDouble.data());
+        for (std::size_t j = 0; j < 3; ++j) {
+            EXPECT_NEAR(softmaxOutDouble[j], softmaxOut[i * 3 + j], 1e-6);
+        }
+    }
+}
+
+TEST(FastForest, PredictLeaves) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    const FF fastForest = fastforest::load_txt("continuous/model.txt", features);
+
+    std::ifstream fileX("continuous/X.csv");
+
+    std::vector<fastforest::FeatureType> input(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+
+    const int nTrees = fastForest.nTrees();
+    std::vector<int> leaves(nSamples * nTrees);
+    std::vector<unsigned short> leavesShort(nSamples * nTrees);
+    fastForest.predictLeaves(input.data(), nSamples, 5, leaves.data());
+    fastForest.predictLeaves(input.data(), nSamples, 5, leavesShort.data());
+
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        // The trees from load_txt have their leaves stored contiguously, and each tree has one more leaf than nodes.
+        fastforest::TreeEnsembleResponseType score = fastForest.baseResponses_[0];
+        for (int iTree = 0; iTree < nTrees; ++iTree) {
+            int leaf = leaves[i * nTrees + iTree];
+            EXPECT_EQ(leaf, leavesShort[i * nTrees + iTree]);
+            score += fastForest.responses_[fastForest.rootIndices_[iTree] + iTree + leaf];
+        }
+        EXPECT_EQ(score, fastForest(input.data() + i * 5));
+    }
+
+    // the same leaves with several threads, row by row, and for a forest whose first leaves are not prepared
+    std::vector<int> leavesThreaded(nSamples * nTrees);
+    fastForest.predictLeaves(input.data(), nSamples, 5, leavesThreaded.data(), 4);
+    EXPECT_EQ(leavesThreaded, leaves);
+
+    std::vector<int> leavesRow(nTrees);
+    for (std::size_t i = 0; i < nSamples; i += 97) {
+        fastForest.predictLeaves(input.data() + i * 5, 1, 5, leavesRow.data());
+        EXPECT_EQ(leavesRow, std::vector<int>(&leaves[i * nTrees], &leaves[i * nTrees] + nTrees));
+    }
+
+    FF unprepared;
+    unprepared.rootIndices_ = fastForest.rootIndices_;
+    unprepared.cutIndices_ = fastForest.cutIndices_;
+    unprepared.cutValues_ = fastForest.cutValues_;
+    unprepared.leftIndices_ = fastForest.leftIndices_;
+    unprepared.rightIndices_ = fastForest.rightIndices_;
+    unprepared.responses_ = fastForest.responses_;
+    unprepared.treeNumbers_ = fastForest.treeNumbers_;
+    unprepared.baseResponses_ = fastForest.baseResponses_;
+    std::vector<int> leavesUnprepared(nSamples * nTrees);
+    unprepared.predictLeaves(input.data(), nSamples, 5, leavesUnprepared.data());
+    EXPECT_EQ(leavesUnprepared, leaves);
+    unprepared.prepareLeafIndices();
+    unprepared.predictLeaves(input.data(), nSamples, 5, leavesUnprepared.data());
+    EXPECT_EQ(leavesUnprepared, leaves);
+}
+
+TEST(FastForest, Contributions) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    {
+        const FF fastForest = fastforest::load_txt("continuous/model_with_stats.txt", features);
+        fastForest.write_bin("continuous/forest_with_stats.bin");
+    }
+    const FF fastForest = fastforest::load_bin("continuous/forest_with_stats.bin");
+
+    std::ifstream fileX("continuous/X.csv");
+    std::ifstream fileContribs("continuous/contribs.csv");
+
+    std::vector<fastforest::FeatureType> input(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+
+    std::vector<fastforest::TreeEnsembleResponseType> contribs(6 * nSamples);
+    fastForest.predictContributions(input.data(), nSamples, 5, 5, contribs.data());
+
+    RefPredictionType ref;
+
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        fastforest::TreeEnsembleResponseType sum = 0.;
+        for (std::size_t j = 0; j < 6; ++j) {
+            fileContribs >> ref;
+            EXPECT_NEAR(contribs[i * 6 + j], ref, tolerance);
+            sum += contribs[i * 6 + j];
+        }
+        EXPECT_NEAR(sum, fastForest(input.data() + i * 5), tolerance);
+    }
+}
+
+TEST(FastForest, SoftmaxContributions) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    const FF fastForest = fastforest::load_txt("softmax/model_with_stats.txt", features, 3);
+
+    std::ifstream fileX("softmax/X.csv");
+    std::ifstream fileContribs("softmax/contribs.csv");
+
+    std::vector<fastforest::FeatureType> input(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+
+    std::vector<fastforest::TreeEnsembleResponseType> contribs(3 * 6 * nSamples);
+    fastForest.predictContributions(input.data(), nSamples, 5, 5, contribs.data(), 4);
+
+    RefPredictionType ref;
+
+    for (std::size_t i = 0; i < contribs.size(); ++i) {
+        fileContribs >> ref;
+        EXPECT_NEAR(contribs[i], ref, tolerance);
+    }
+}
+
+TEST(FastForest, Profile) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    const FF fastForest = fastforest::load_txt("continuous/model.txt", features);
+
+    std::ifstream fileX("continuous/X.csv");
+
+    std::vector<fastforest::FeatureType> input(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+
+    // profile in two batches to check the accumulation
+    fastforest::ForestProfile profile;
+    fastForest.profile(input.data(), nSamples / 2, 5, profile);
+    fastForest.profile(input.data() + nSamples / 2 * 5, nSamples - nSamples / 2, 5, profile);
+
+    EXPECT_EQ(profile.nRows, nSamples);
+
+    std::size_t nodeVisits = 0;
+    std::size_t treeNodeVisits = 0;
+    std::size_t featureAccesses = 0;
+    std::size_t leafHits = 0;
+    for (std::size_t i = 0; i < profile.nodeVisits.size(); ++i) {
+        EXPECT_LE(profile.leftTaken[i], profile.nodeVisits[i]);
+        nodeVisits += profile.nodeVisits[i];
+    }
+    for (std::size_t i = 0; i < profile.treeNodeVisits.size(); ++i) {
+        EXPECT_EQ(profile.nodeVisits[fastForest.rootIndices_[i]], nSamples);
+        treeNodeVisits += profile.treeNodeVisits[i];
+    }
+    for (std::size_t i = 0; i < profile.featureAccesses.size(); ++i) {
+        featureAccesses += profile.featureAccesses[i];
+    }
+    for (std::size_t i = 0; i < profile.leafHits.size(); ++i) {
+        leafHits += profile.leafHits[i];
+    }
+    EXPECT_EQ(nodeVisits, treeNodeVisits);
+    EXPECT_EQ(nodeVisits, featureAccesses);
+    EXPECT_EQ(leafHits, nSamples * fastForest.nTrees());
+
+    std::stringstream report;
+    profile.write_report(report);
+    EXPECT_FALSE(report.str().empty());
+}
+
+TEST(FastForest, OptimizeLayout) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    const FF fastForest = fastforest::load_txt("continuous/model.txt", features);
+
+    std::ifstream fileX("continuous/X.csv");
+
+    std::vector<fastforest::FeatureType> input(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+
+    fastforest::ForestProfile profile;
+    fastForest.profile(input.data(), nSamples, 5, profile);
+
+    fastforest::optimize_layout(fastForest, profile).write_bin("continuous/forest_optimized.bin");
+    const FF optimized = fastforest::load_bin("continuous/forest_optimized.bin");
+
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        EXPECT_EQ(optimized(input.data() + i * 5), fastForest(input.data() + i * 5));
+    }
+
+    // the more frequently taken child node should now always come right after its parent
+    fastforest::ForestProfile optimizedProfile;
+    optimized.profile(input.data(), nSamples, 5, optimizedProfile);
+    for (std::size_t i = 0; i < optimized.cutValues_.size(); ++i) {
+        const bool leftIsHot = 2 * optimizedProfile.leftTaken[i] >= optimizedProfile.nodeVisits[i];
+        const int hotChild = leftIsHot ? optimized.leftIndices_[i] : optimized.rightIndices_[i];
+        if (hotChild > 0) {
+            EXPECT_EQ(hotChild, static_cast<int>(i) + 1);
+        }
+    }
+}
+
+TEST(FastForest, Compress) {
+    // A small handmade forest with a split that doesn't matter, an identical subtree in two trees, and a tree that
+    // doesn't depend on the input at all.
+    FF forest;
+    forest.baseResponses_.push_back(0.0);
+    const int cutIndices[] = {0, 1, 2, 2, 1};
+    const fastforest::FeatureType cutValues[] = {0.5, 1.0, 2.0, 2.0, 3.0};
+    const int leftIndices[] = {1, 0, -2, -4, -6};
+    const int rightIndices[] = {2, -1, -3, -5, -7};
+    const fastforest::TreeResponseType responses[] = {0.25, 0.25, 0.5, 0.75, 0.5, 0.75, 1.0, 1.0};
+    forest.cutIndices_.assign(cutIndices, cutIndices + 5);
+    forest.cutValues_.assign(cutValues, cutValues + 5);
+    forest.leftIndices_.assign(leftIndices, leftIndices + 5);
+    forest.rightIndices_.assign(rightIndices, rightIndices + 5);
+    forest.responses_.assign(responses, responses + 8);
+    for (int i = 0; i < 3; ++i) {
+        forest.rootIndices_.push_back(i == 0 ? 0 : i + 2);
+        forest.treeNumbers_.push_back(i);
+    }
+
+    fastforest::CompressionReport report;
+    const FF compressed = fastforest::compress(forest, &report);
+
+    EXPECT_EQ(report.nTreesBefore, 3);
+    EXPECT_EQ(report.nTreesAfter, 2);
+    EXPECT_EQ(report.nNodesBefore, 5);
+    EXPECT_EQ(report.nNodesAfter, 2);
+    EXPECT_EQ(report.nLeavesBefore, 8);
+    EXPECT_EQ(report.nLeavesAfter, 3);
+    EXPECT_LT(report.bytesAfter, report.bytesBefore);
+
+    std::vector<fastforest::FeatureType> input(3);
+    for (int i = 0; i < 4 * 4 * 4; ++i) {
+        input[0] = i % 4;
+        input[1] = i / 4 % 4;
+        input[2] = i / 16;
+        EXPECT_EQ(compressed(input.data()), forest(input.data()));
+    }
+}
+
+TEST(FastForest, CompressSoftmax) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    const FF fastForest = fastforest::load_txt("softmax/model.txt", features, 3);
+
+    fastforest::CompressionReport report;
+    const FF compressed = fastforest::compress(fastForest, &report);
+    EXPECT_LE(report.nNodesAfter, report.nNodesBefore);
+    EXPECT_LE(report.nLeavesAfter, report.nLeavesBefore);
+
+    std::ifstream fileX("softmax/X.csv");
+
+    std::vector<fastforest::FeatureType> input(5);
+
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        for (std::size_t j = 0; j < input.size(); ++j) {
+            fileX >> input[j];
+        }
+        std::vector<float> output = compressed.softmax(input.data());
+        std::vector<float> ref = fastForest.softmax(input.data());
+        for (std::size_t j = 0; j < output.size(); ++j) {
+            CHECK_CLOSE(output[j], ref[j], tolerance);
+        }
+    }
+}
+
+TEST(FastForest, LowLatencyForest) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    const FF binaryForest = fastforest::load_txt("continuous/model.txt", features);
+    const FF softmaxForest = fastforest::load_txt("softmax/model.txt", features, 3);
+
+    // too few trees per thread, so this is evaluated serially
+    const fastforest::LowLatencyForest serialForest(binaryForest, 4, 1000);
+    EXPECT_EQ(serialForest.nThreads(), 1);
+
+    const fastforest::LowLatencyForest binaryLowLatency(binaryForest, 3, 10);
+    const fastforest::LowLatencyForest softmaxLowLatency(softmaxForest, 2, 10);
+    // the number of threads is one if the library was compiled without C++11
+    EXPECT_TRUE(binaryLowLatency.nThreads() == 3 || binaryLowLatency.nThreads() == 1);
+
+    std::ifstream fileX("softmax/X.csv");
+
+    std::vector<fastforest::FeatureType> input(5);
+
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        for (std::size_t j = 0; j < input.size(); ++j) {
+            fileX >> input[j];
+        }
+        EXPECT_EQ(serialForest(input.data()), binaryForest(input.data()));
+        EXPECT_NEAR(binaryLowLatency(input.data()), binaryForest(input.data()), 1e-5);
+        std::vector<float> ref = softmaxForest.softmax(input.data());
+        std::vector<float> probas = softmaxLowLatency.softmax(input.data());
+        for (std::size_t j = 0; j < 3; ++j) {
+            EXPECT_NEAR(probas[j], ref[j], 1e-6);
+        }
+    }
+}
+
+TEST(FastForest, Quantize) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    const FF fastForest = fastforest::load_txt("softmax/model.txt", features, 3);
+
+    std::ifstream fileX("softmax/X.csv");
+
+    std::vector<fastforest::FeatureType> input(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+
+    const fastforest::LeafPrecision precisions[] = {
+        fastforest::LeafFloat16, fastforest::LeafBFloat16, fastforest::LeafInt8};
+    // relative precision of the leaf values in each format
+    const double leafTolerances[] = {1. / 2048, 1. / 256, 0.5 / 127};
+
+    for (int iPrecision = 0; iPrecision < 3; ++iPrecision) {
+        fastforest::QuantizationReport report;
+        const fastforest::QuantizedForest quantized =
+            fastforest::quantize(fastForest, precisions[iPrecision], input.data(), nSamples, 5, &report);
+        EXPECT_LT(report.bytesAfter, report.bytesBefore);
+
+        double maxAbsLeaf = 0.;
+        for (std::size_t i = 0; i < fastForest.responses_.size(); ++i) {
+            maxAbsLeaf = std::max(maxAbsLeaf, std::abs(static_cast<double>(fastForest.responses_[i])));
+        }
+        EXPECT_GT(report.maxLeafError, 0.);
+        EXPECT_LE(report.maxLeafError, maxAbsLeaf * leafTolerances[iPrecision]);
+
+        double maxError = 0.;
+        std::vector<float> scores(3 * nSamples);
+        std::vector<float> reference(3 * nSamples);
+        quantized.predict(input.data(), nSamples, 5, scores.data());
+        fastForest.predict(input.data(), nSamples, 5, reference.data());
+        for (std::size_t i = 0; i < scores.size(); ++i) {
+            maxError = std::max(maxError, std::abs(static_cast<double>(scores[i]) - reference[i]));
+        }
+        EXPECT_EQ(maxError, report.maxPredictionError);
+        EXPECT_LE(maxError, fastForest.nTrees() / 3 * report.maxLeafError + 1e-5);
+
+        std::vector<float> probas = quantized.softmax(input.data());
+        std::vector<float> ref = fastForest.softmax(input.data());
+        for (std::size_t j = 0; j < 3; ++j) {
+            EXPECT_NEAR(probas[j], ref[j], 0.05);
+        }
+
+        // the quantized leaf values are written and read back exactly
+        quantized.write_bin("softmax/forest_quantized.bin");
+        const fastforest::QuantizedForest loaded = fastforest::load_quantized_bin("softmax/forest_quantized.bin");
+        EXPECT_EQ(loaded.precision(), precisions[iPrecision]);
+        EXPECT_EQ(loaded.size(), quantized.size());
+        std::vector<float> loadedScores(3 * nSamples);
+        loaded.predict(input.data(), nSamples, 5, loadedScores.data());
+        EXPECT_EQ(loadedScores, scores);
+    }
+    fastForest.write_bin("softmax/forest_not_quantized.bin");
+    EXPECT_THROW(fastforest::load_quantized_bin("softmax/forest_not_quantized.bin"), std::runtime_error);
+}
+
+TEST(FastForest, Autotune) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    const FF fastForest = fastforest::load_txt("softmax/model.txt", features, 3);
+
+    std::ifstream fileX("softmax/X.csv");
+
+    std::vector<fastforest::FeatureType> input(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+
+    const fastforest::EngineChoice choice = fastforest::autotune(fastForest, input.data(), nSamples, 5, 2);
+    EXPECT_GT(choice.secondsPerRow, 0.);
+
+    const fastforest::TunedForest tuned(fastForest, choice);
+    std::vector<float> scores(3 * nSamples);
+    std::vector<float> reference(3 * nSamples);
+    tuned.predict(input.data(), nSamples, 5, scores.data());
+    fastForest.predict(input.data(), nSamples, 5, reference.data());
+    EXPECT_EQ(scores, reference);
+
+    choice.write("engine_choice.txt");
+    fastforest::EngineChoice loaded;
+    EXPECT_TRUE(fastforest::load_engine_choice("engine_choice.txt", fastForest, loaded));
+    EXPECT_EQ(loaded.engine, choice.engine);
+    EXPECT_EQ(loaded.blockSize, choice.blockSize);
+    EXPECT_EQ(loaded.nThreads, choice.nThreads);
+    EXPECT_EQ(loaded.fingerprint, choice.fingerprint);
+
+    // the choice was tuned for a different model
+    const FF otherForest = fastforest::load_txt("continuous/model.txt", features);
+    EXPECT_FALSE(fastforest::load_engine_choice("engine_choice.txt", otherForest, loaded));
+    EXPECT_FALSE(fastforest::load_engine_choice("does_not_exist.txt", fastForest, loaded));
+}
+
+TEST(FastForest, GridForest) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    const FF fastForest = fastforest::load_txt("discrete/model.txt", features);
+
+    std::ifstream fileX("discrete/X.csv");
+
+    std::vector<fastforest::FeatureType> input(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+
+    fastforest::GridForest grid;
+    std::size_t required = 0;
+    EXPECT_FALSE(fastforest::compile_grid(fastForest, grid, 1000, &required));
+    EXPECT_GT(required, 1000u);
+    EXPECT_EQ(grid.nCells(), 0u);
+
+    EXPECT_TRUE(fastforest::compile_grid(fastForest, grid, required, &required));
+    EXPECT_EQ(grid.size(), required);
+    EXPECT_GT(grid.nCells(), 1u);
+
+    std::vector<float> scores(nSamples);
+    std::vector<float> reference(nSamples);
+    grid.predict(input.data(), nSamples, 5, scores.data());
+    fastForest.predict(input.data(), nSamples, 5, reference.data());
+    EXPECT_EQ(scores, reference);
+
+    fastforest::EngineChoice choice;
+    choice.engine = fastforest::EngineGrid;
+    const fastforest::TunedForest tuned(fastForest, choice);
+    tuned.predict(input.data(), nSamples, 5, scores.data());
+    EXPECT_EQ(scores, reference);
+
+    // values on the thresholds, below and above all thresholds, and missing values
+    std::vector<fastforest::FeatureType> row(input.begin(), input.begin() + 5);
+    for (std::size_t i = 0; i < fastForest.cutValues_.size(); i += 7) {
+        row[fastForest.cutIndices_[i]] = fastForest.cutValues_[i];
+        EXPECT_EQ(grid(row.data()), fastForest(row.data()));
+    }
+    const fastforest::FeatureType specialValues[] = {-1e30f, 1e30f, std::numeric_limits<float>::quiet_NaN()};
+    for (int i = 0; i < 3; ++i) {
+        row[i + 1] = specialValues[i];
+        EXPECT_EQ(grid(row.data()), fastForest(row.data()));
+    }
+
+    // the continuous model has too many different thresholds
+    const FF continuousForest = fastforest::load_txt("continuous/model.txt", features);
+    EXPECT_FALSE(fastforest::compile_grid(continuousForest, grid, std::size_t(1) << 30, &required));
+    EXPECT_GT(required, std::size_t(1) << 30);
+    EXPECT_GT(grid.nCells(), 1u);
+}
+
+TEST(FastForest, JitForest) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    std::ifstream fileX("softmax/X.csv");
+    std::vector<fastforest::FeatureType> input(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+    // some missing values, which go to the right child
+    input[3] = std::numeric_limits<float>::quiet_NaN();
+    input[11] = std::numeric_limits<float>::quiet_NaN();
+
+    const FF binaryForest = fastforest::load_txt("continuous/model.txt", features);
+    const FF softmaxForest = fastforest::load_txt("softmax/model.txt", features, 3);
+    // with subtrees that are shared within the trees
+    const FF compressedForest = fastforest::compress(softmaxForest);
+    const FF* forests[] = {&binaryForest, &softmaxForest, &compressedForest};
+
+    for (int iForest = 0; iForest < 3; ++iForest) {
+        FF const& fastForest = *forests[iForest];
+        const fastforest::JitForest jit(fastForest);
+        EXPECT_EQ(jit.codeSize() > 0, jit.isNative());
+
+        const int nOut = fastForest.nOutputs();
+        std::vector<float> scores(nOut * nSamples);
+        std::vector<float> reference(nOut * nSamples);
+        jit.predict(input.data(), nSamples, 5, scores.data());
+        fastForest.predict(input.data(), nSamples, 5, reference.data());
+        EXPECT_EQ(scores, reference);
+
+        const fastforest::JitForest copy(jit);
+        EXPECT_EQ(copy.isNative(), jit.isNative());
+        EXPECT_EQ(copy(input.data()), fastForest(input.data()));
+    }
+
+    std::vector<float> probas = fastforest::JitForest(softmaxForest).softmax(input.data());
+    std::vector<float> ref = softmaxForest.softmax(input.data());
+    EXPECT_EQ(probas, ref);
+}
+
+TEST(FastForest, Registry) {
+    fastforest::ForestRegistry registry;
+    const int binaryModel = registry.load_txt("continuous/model.txt");
+    const int softmaxModel = registry.load_txt("softmax/model.txt", 3);
+
+    EXPECT_EQ(registry.nModels(), 2);
+    EXPECT_EQ(registry.nOutputs(), 4);
+    EXPECT_EQ(registry.features_.size(), 5u);
+
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    // a forest with too few feature names is rejected without adding any of its names
+    std::vector<std::string> tooFewFeatures;
+    tooFewFeatures.push_back("unused0");
+    tooFewFeatures.push_back("unused1");
+    EXPECT_THROW(registry.add(fastforest::load_txt("continuous/model.txt", features), tooFewFeatures),
+                 std::runtime_error);
+    EXPECT_EQ(registry.nModels(), 2);
+    EXPECT_EQ(registry.features_.size(), 5u);
+
+    const FF binaryForest = fastforest::load_txt("continuous/model.txt", features);
+    const FF softmaxForest = fastforest::load_txt("softmax/model.txt", features, 3);
+
+    std::ifstream fileX("continuous/X.csv");
+
+    // the rows for the registry need to be in the order of the unified feature list
+    std::vector<fastforest::FeatureType> input(5 * nSamples);
+    std::vector<fastforest::FeatureType> registryInput(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        for (std::size_t j = 0; j < 5; ++j) {
+            int original = std::atoi(registry.features_[j].c_str() + 1);
+            registryInput[i * 5 + j] = input[i * 5 + original];
+        }
+    }
+
+    std::vector<fastforest::TreeEnsembleResponseType> out(4 * nSamples);
+    registry.evaluate(registryInput.data(), nSamples, 5, out.data());
+
+    const int subset[] = {softmaxModel};
+    std::vector<fastforest::TreeEnsembleResponseType> outSubset(3 * nSamples);
+    registry.evaluate(registryInput.data(), nSamples, 5, subset, 1, outSubset.data());
+
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        EXPECT_EQ(out[i * 4 + registry.outputOffsets_[binaryModel]], binaryForest(input.data() + i * 5));
+
+        fastforest::TreeEnsembleResponseType* softmaxOut = &out[i * 4 + registry.outputOffsets_[softmaxModel]];
+        fastforest::details::softmaxTransformInplace(softmaxOut, 3);
+        fastforest::details::softmaxTransformInplace(&outSubset[i * 3], 3);
+        std::vector<float> ref = softmaxForest.softmax(input.data() + i * 5);
+        for (std::size_t j = 0; j < 3; ++j) {
+            EXPECT_EQ(softmaxOut[j], ref[j]);
+            EXPECT_EQ(outSubset[i * 3 + j], ref[j]);
+        }
+    }
+}
+
+TEST(FastForest, ArenaForest) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    const FF fastForest = fastforest::load_txt("softmax/model_with_stats.txt", features, 3);
+    fastForest.write_bin("softmax/forest_with_stats.bin");
+
+    fastforest::ArenaForest arenaForest(fastForest);
+    EXPECT_EQ(reinterpret_cast<std::size_t>(arenaForest.data()) % 64, 0u);
+
+    // the memory block should have exactly the content of the binary file
+    std::ifstream fileBin("softmax/forest_with_stats.bin", std::ios::binary);
+    std::string binContent((std::istreambuf_iterator<char>(fileBin)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(binContent, std::string(arenaForest.data(), arenaForest.size()));
+
+    const fastforest::ArenaForest loaded = fastforest::load_arena_bin("softmax/forest_with_stats.bin");
+    fastforest::ArenaForest copied;
+    copied = loaded;
+    const FF roundTripped = copied.toFastForest();
+    EXPECT_EQ(roundTripped.leafCovers_, fastForest.leafCovers_);
+
+    // files that are shorter than the arrays in their header are rejected
+    std::ofstream truncated("softmax/forest_truncated.bin", std::ios::binary);
+    truncated.write(binContent.data(), binContent.size() / 2);
+    truncated.close();
+    EXPECT_THROW(fastforest::load_arena_bin("softmax/forest_truncated.bin"), std::runtime_error);
+    std::ofstream tiny("softmax/forest_truncated.bin", std::ios::binary);
+    tiny.write(binContent.data(), 5);
+    tiny.close();
+    EXPECT_THROW(fastforest::load_arena_bin("softmax/forest_truncated.bin"), std::runtime_error);
+
+    std::ifstream fileX("softmax/X.csv");
+
+    std::vector<fastforest::FeatureType> input(5);
+
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        for (std::size_t j = 0; j < input.size(); ++j) {
+            fileX >> input[j];
+        }
+        std::vector<float> ref = fastForest.softmax(input.data());
+        EXPECT_EQ(arenaForest.softmax(input.data()), ref);
+        EXPECT_EQ(copied.softmax(input.data()), ref);
+        EXPECT_EQ(roundTripped.softmax(input.data()), ref);
+    }
+
+    const FF binaryForest = fastforest::load_txt("continuous/model.txt", features);
+    const fastforest::ArenaForest binaryArenaForest(binaryForest);
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        input[i % 5] = 0.1 * i - 5.0;
+        EXPECT_EQ(binaryArenaForest(input.data()), binaryForest(input.data()));
+    }
+}
+
+TEST(FastForest, NumaForest) {
+    std::vector<std::string> features;
+    fillFeaturesFive(features);
+
+    const FF fastForest = fastforest::load_txt("softmax/model.txt", features, 3);
+    const fastforest::NumaForest numaForest(fastForest);
+    EXPECT_GE(numaForest.nReplicas(), 1);
+
+    std::ifstream fileX("softmax/X.csv");
+
+    std::vector<fastforest::FeatureType> input(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+
+    std::vector<fastforest::TreeEnsembleResponseType> out(3 * nSamples);
+    numaForest.evaluate(input.data(), nSamples, 5, out.data(), 4);
+
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        fastforest::details::softmaxTransformInplace(&out[i * 3], 3);
+        std::vector<float> ref = fastForest.softmax(input.data() + i * 5);
+        for (std::size_t j = 0; j < 3; ++j) {
+            EXPECT_EQ(out[i * 3 + j], ref[j]);
+        }
+    }
+}
+
+TEST(FastForest, CApi) {
+    const char* features[] = {"f0", "f1", "f2", "f3", "f4"};
+    char error[256] = "";
+
+    EXPECT_TRUE(fastforest_load_txt("nonexistent.txt", features, 5, 2, error, sizeof(error)) == NULL);
+    EXPECT_NE(std::string(error), "");
+
+    fastforest_forest* forest = fastforest_load_txt("softmax/model.txt", features, 5, 3, error, sizeof(error));
+    ASSERT_TRUE(forest != NULL) << error;
+    EXPECT_EQ(fastforest_n_features(forest), 5);
+    EXPECT_EQ(std::string(fastforest_feature_name(forest, 3)), "f3");
+    EXPECT_EQ(fastforest_n_outputs(forest), 3);
+
+    std::ifstream fileX("softmax/X.csv");
+    std::ifstream filePreds("softmax/preds.csv");
+
+    std::vector<float> input(5 * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+
+    std::vector<float> probas(3 * nSamples);
+    ASSERT_EQ(fastforest_softmax(forest, input.data(), nSamples, 5, probas.data(), 2, error, sizeof(error)), 0);
+    for (std::size_t i = 0; i < probas.size(); ++i) {
+        double ref;
+        filePreds >> ref;
+        EXPECT_NEAR(probas[i], ref, 1e-5);
+    }
+
+    // the same model loaded from binary format in memory
+    ASSERT_EQ(fastforest_write_bin(forest, "softmax.bin", error, sizeof(error)), 0);
+    std::ifstream fileBin("softmax.bin", std::ios::binary);
+    std::stringstream ss;
+    ss << fileBin.rdbuf();
+    const std::string bin = ss.str();
+    fastforest_forest* binForest = fastforest_load_bin_buffer(bin.data(), bin.size(), error, sizeof(error));
+    ASSERT_TRUE(binForest != NULL) << error;
+
+    std::vector<float> scores(3 * nSamples);
+    std::vector<float> binScores(3 * nSamples);
+    std::vector<int> leaves(fastforest_n_trees(forest) * nSamples);
+    fastforest_predict(forest, input.data(), nSamples, 5, scores.data(), 1, NULL, 0);
+    fastforest_predict(binForest, input.data(), nSamples, 5, binScores.data(), 1, NULL, 0);
+    EXPECT_EQ(scores, binScores);
+    std::vector<double> scoresDouble(3 * nSamples);
+    EXPECT_EQ(fastforest_predict_double(forest, input.data(), nSamples, 5, scoresDouble.data(), 1, NULL, 0), 0);
+    for (std::size_t i = 0; i < scores.size(); ++i) {
+        EXPECT_NEAR(scoresDouble[i], scores[i], 1e-5);
+    }
+    EXPECT_EQ(fastforest_predict_leaves(forest, input.data(), nSamples, 5, leaves.data(), NULL, 0), 0);
+
+    EXPECT_NE(fastforest_predict(NULL, input.data(), nSamples, 5, scores.data(), 1, error, sizeof(error)), 0);
+    EXPECT_NE(fastforest_write_bin(NULL, "softmax.bin", error, sizeof(error)), 0);
+    EXPECT_EQ(fastforest_n_trees(NULL), 0);
+    EXPECT_TRUE(fastforest_feature_name(NULL, 0) == NULL);
+
+    // missing and truncated files are reported as errors
+    EXPECT_TRUE(fastforest_load_bin("nonexistent.bin", error, sizeof(error)) == NULL);
+    std::ofstream truncated("softmax_truncated.bin", std::ios::binary);
+    truncated.write(bin.data(), bin.size() / 2);
+    truncated.close();
+    EXPECT_TRUE(fastforest_load_bin("softmax_truncated.bin", error, sizeof(error)) == NULL);
+
+    fastforest_free(binForest);
+    fastforest_free(forest);
+}
+
 TEST(FastForest, Discrete) {
     std::vector<std::string> features;
     fillFeaturesFive(features);
@@ -254,6 +1400,111 @@ TEST(FastForest, ManyFeatures) {
     }
 }
 
+TEST(FastForest, IncrementalForest) {
+    std::vector<std::string> features;
+    for (int i = 0; i < 311; ++i) {
+        std::stringstream ss;
+        ss << "f" << i;
+        features.push_back(ss.str());
+    }
+
+    const FF fastForest = fastforest::load_txt("manyfeatures/model.txt", features);
+    const fastforest::IncrementalForest incremental(fastForest);
+
+    std::ifstream fileX("manyfeatures/X.csv");
+
+    std::vector<fastforest::FeatureType> input(features.size() * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+
+    const int nTrees = fastForest.nTrees();
+    int nUsages = 0;
+    for (std::size_t iFeature = 0; iFeature < features.size(); ++iFeature) {
+        const int* trees = incremental.treesUsing(iFeature);
+        for (int i = 0; i < incremental.nTreesUsing(iFeature); ++i) {
+            EXPECT_TRUE(i == 0 || trees[i] > trees[i - 1]);
+            EXPECT_LT(trees[i], nTrees);
+        }
+        nUsages += incremental.nTreesUsing(iFeature);
+    }
+    EXPECT_GT(nUsages, 0);
+    EXPECT_EQ(incremental.nTreesUsing(-1), 0);
+    EXPECT_EQ(incremental.nTreesUsing(features.size()), 0);
+
+    std::vector<fastforest::TreeResponseType> treeValues(nTrees);
+    std::vector<fastforest::TreeResponseType> refTreeValues(nTrees);
+    float score;
+    float refScore;
+    std::vector<fastforest::FeatureType> row(input.begin(), input.begin() + features.size());
+    incremental.evaluate(row.data(), treeValues.data(), &score);
+    CHECK_CLOSE(score, fastForest(row.data()), 1e-5);
+
+    // change one, two and then three features to the values of the following rows
+    for (std::size_t iRow = 1; iRow < 20; ++iRow) {
+        const int nChanged = 1 + iRow % 3;
+        std::vector<int> changed;
+        for (int i = 0; i < nChanged; ++i) {
+            changed.push_back((iRow * 37 + i * 101) % features.size());
+            row[changed.back()] = input[iRow * features.size() + changed.back()];
+        }
+        const int nEvaluated =
+            incremental.update(row.data(), changed.data(), nChanged, treeValues.data(), &score);
+        EXPECT_LE(nEvaluated, nTrees);
+
+        incremental.evaluate(row.data(), refTreeValues.data(), &refScore);
+        EXPECT_EQ(treeValues, refTreeValues);
+        CHECK_CLOSE(score, refScore, 1e-4);
+        CHECK_CLOSE(refScore, fastForest(row.data()), 1e-5);
+    }
+}
+
+TEST(FastForest, CompactForest) {
+    std::vector<std::string> features;
+    for (int i = 0; i < 311; ++i) {
+        std::stringstream ss;
+        ss << "f" << i;
+        features.push_back(ss.str());
+    }
+
+    const FF fastForest = fastforest::load_txt("manyfeatures/model.txt", features);
+
+    std::ifstream fileX("manyfeatures/X.csv");
+
+    std::vector<fastforest::FeatureType> input(features.size() * nSamples);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        fileX >> input[i];
+    }
+
+    std::vector<float> reference(nSamples);
+    fastForest.predict(input.data(), nSamples, features.size(), reference.data());
+
+    fastforest::ForestProfile profile;
+    fastForest.profile(input.data(), nSamples, features.size(), profile);
+
+    for (int withProfile = 0; withProfile < 2; ++withProfile) {
+        const fastforest::CompactForest compact(fastForest, withProfile ? &profile : NULL);
+        EXPECT_GT(compact.nUsedFeatures(), 0);
+        EXPECT_LE(compact.nUsedFeatures(), static_cast<int>(features.size()));
+
+        std::vector<float> scores(nSamples);
+        compact.predict(input.data(), nSamples, features.size(), scores.data(), 2);
+        EXPECT_EQ(scores, reference);
+
+        std::vector<fastforest::FeatureType> row(compact.nUsedFeatures());
+        compact.gather(input.data(), row.data());
+        EXPECT_EQ(compact.forest()(row.data()), fastForest(input.data()));
+
+        if (withProfile) {
+            // the most frequently read features come first
+            std::vector<int> const& used = compact.usedFeatures();
+            for (std::size_t i = 1; i < used.size(); ++i) {
+                EXPECT_GE(profile.featureAccesses[used[i - 1]], profile.featureAccesses[used[i]]);
+            }
+        }
+    }
+}
+
 #ifdef EXPERIMENTAL_TMVA_SUPPORT
 
 TEST(FastForest, BasicTMVAXML) {
@@ -278,6 +1529,22 @@ TEST(FastForest, BasicTMVAXML) {
 
         CHECK_CLOSE(score, ref, tolerance);
     }
+
+    for (int nThreads = 2; nThreads <= 7; nThreads += 5) {
+        std::vector<std::string> parallelFeatures;
+        fillFeaturesFive(parallelFeatures);
+        const FF parallel = fastforest::load_tmva_xml("continuous/model.xml", parallelFeatures, nThreads);
+
+        EXPECT_EQ(parallelFeatures, features);
+        EXPECT_EQ(parallel.rootIndices_, fastForest.rootIndices_);
+        EXPECT_EQ(parallel.cutIndices_, fastForest.cutIndices_);
+        EXPECT_EQ(parallel.cutValues_, fastForest.cutValues_);
+        EXPECT_EQ(parallel.leftIndices_, fastForest.leftIndices_);
+        EXPECT_EQ(parallel.rightIndices_, fastForest.rightIndices_);
+        EXPECT_EQ(parallel.responses_, fastForest.responses_);
+        EXPECT_EQ(parallel.treeNumbers_, fastForest.treeNumbers_);
+        EXPECT_EQ(parallel.baseResponses_, fastForest.baseResponses_);
+    }
 }
 
 #endif
@@ -0,0 +1,38 @@
+import numpy as np
+import pandas as pd
+
+# Build with -DBUILD_PYTHON_MODULE=ON and put the build directory of the module in the PYTHONPATH
+import fastforest
+
+features = ["f0", "f1", "f2", "f3", "f4"]
+
+X = pd.read_csv("continuous/X.csv", header=None, delimiter=" ").to_numpy(dtype=np.float32)
+preds_ref = pd.read_csv("continuous/preds.csv", header=None, delimiter=" ").to_numpy().T[0]
+
+fast_forest = fastforest.load_txt("continuous/model.txt", features)
+
+preds_ff = fast_forest.predict(X, n_threads=4)
+np.testing.assert_allclose(preds_ff, preds_ref, rtol=1e-5, atol=1e-5)
+
+# Fortran-ordered and strided arrays are supported too
+np.testing.assert_allclose(fast_forest.predict(np.asfortranarray(X)), preds_ff)
+np.testing.assert_allclose(fast_forest.predict(X[::2]), preds_ff[::2])
+
+leaves = fast_forest.predict_leaves(X)
+assert leaves.shape == (X.shape[0], fast_forest.n_trees)
+
+# the scores of binary classification models are no probabilities
+try:
+    fast_forest.softmax(X)
+    raise AssertionError("softmax() should fail for binary classification models")
+except ValueError:
+    pass
+
+X = pd.read_csv("softmax/X.csv", header=None, delimiter=" ").to_numpy(dtype=np.float32)
+preds_ref = pd.read_csv("softmax/preds.csv", header=None, delimiter=" ").to_numpy()
+
+fast_forest = fastforest.load_txt("softmax/model.txt", features, n_classes=3)
+
+np.testing.assert_allclose(fast_forest.softmax(X), preds_ref, rtol=1e-5, atol=1e-5)
+
+print("all good")
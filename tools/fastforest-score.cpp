@@ -0,0 +1,451 @@
+/**
+
+MIT License
+
+Copyright (c) 2025 Jonas Rembser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// Command-line tool to score rows from CSV or raw float32 files with a FastForest model.
+//
+// The input is read in chunks, and reading the next chunk and writing the results of the previous chunk happens in
+// the background while the current chunk is scored with all threads.
+
+#include <fastforest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    const char* usage =
+        "usage: fastforest-score --model <model.txt|model.bin|model.xml> --input <file|-> [options]\n"
+        "\n"
+        "options:\n"
+        "  --output <file|->        where to write the scores (default: -, the standard output)\n"
+        "  --input-format <fmt>     csv (comma or whitespace separated) or f32 (default: f32 for .f32 files, csv otherwise)\n"
+        "  --output-format <fmt>    csv or f32 (default: f32 if the output file ends with .f32, csv otherwise)\n"
+        "  --features <f0,f1,...>   feature names in the order of the input columns, needed for text dumps\n"
+        "                           (default: the CSV header if there is one, otherwise f0, f1, ...)\n"
+        "  --n-features <n>         number of input columns, needed for f32 input without --features\n"
+        "  --n-classes <n>          number of classes for multiclassification models in text format (default: 2)\n"
+        "  --softmax                apply the softmax transformation to the scores of multiclassification models\n"
+        "  --threads <n>            number of threads for the scoring (default: number of CPUs)\n"
+        "  --chunk-size <n>         number of rows per chunk (default: 65536)\n"
+        "  --numa                   replicate the model on each NUMA node\n";
+
+    bool endsWith(std::string const& str, std::string const& suffix) {
+        return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    std::vector<std::string> split(std::string const& str, char delimiter) {
+        std::vector<std::string> items;
+        std::stringstream ss(str);
+        std::string item;
+        while (std::getline(ss, item, delimiter)) {
+            items.push_back(item);
+        }
+        return items;
+    }
+
+    bool isSeparator(char c) { return c == ',' || c == ' ' || c == '\t' || c == ';'; }
+
+    // Splits a line of delimiter-separated values, where the delimiter can be a comma, whitespace or a semicolon
+    std::vector<std::string> splitColumns(std::string const& line) {
+        std::vector<std::string> columns;
+        std::size_t pos = 0;
+        while (pos < line.size() && line[pos] != '\r') {
+            std::size_t end = pos;
+            while (end < line.size() && !isSeparator(line[end]) && line[end] != '\r') {
+                ++end;
+            }
+            columns.push_back(line.substr(pos, end - pos));
+            pos = end;
+            while (pos < line.size() && isSeparator(line[pos])) {
+                ++pos;
+            }
+        }
+        return columns;
+    }
+
+    struct Options {
+        Options()
+            : output("-"), nFeatures(0), nClasses(2), softmax(false), nThreads(0), chunkSize(65536), numa(false) {}
+
+        std::string model;
+        std::string input;
+        std::string output;
+        std::string inputFormat;
+        std::string outputFormat;
+        std::vector<std::string> features;
+        int nFeatures;
+        int nClasses;
+        bool softmax;
+        int nThreads;
+        int chunkSize;
+        bool numa;
+    };
+
+    Options parseOptions(int argc, char** argv) {
+        Options opts;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--softmax") {
+                opts.softmax = true;
+                continue;
+            } else if (arg == "--numa") {
+                opts.numa = true;
+                continue;
+            } else if (arg == "--help" || arg == "-h") {
+                std::cout << usage;
+                std::exit(0);
+            } else if (arg.compare(0, 2, "--") != 0) {
+                throw std::runtime_error("unexpected argument " + arg);
+            } else if (i + 1 == argc) {
+                throw std::runtime_error("missing value for " + arg);
+            }
+            if (arg == "--model") {
+                opts.model = argv[++i];
+            } else if (arg == "--input") {
+                opts.input = argv[++i];
+            } else if (arg == "--output") {
+                opts.output = argv[++i];
+            } else if (arg == "--input-format") {
+                opts.inputFormat = argv[++i];
+            } else if (arg == "--output-format") {
+                opts.outputFormat = argv[++i];
+            } else if (arg == "--features") {
+                opts.features = split(argv[++i], ',');
+            } else if (arg == "--n-features") {
+                opts.nFeatures = std::atoi(argv[++i]);
+            } else if (arg == "--n-classes") {
+                opts.nClasses = std::atoi(argv[++i]);
+            } else if (arg == "--threads") {
+                opts.nThreads = std::atoi(argv[++i]);
+            } else if (arg == "--chunk-size") {
+                opts.chunkSize = std::atoi(argv[++i]);
+            } else {
+                throw std::runtime_error("unknown option " + arg);
+            }
+        }
+        if (opts.model.empty() || opts.input.empty()) {
+            throw std::runtime_error("--model and --input are required");
+        }
+        if (opts.inputFormat.empty()) {
+            opts.inputFormat = endsWith(opts.input, ".f32") ? "f32" : "csv";
+        }
+        if (opts.outputFormat.empty()) {
+            opts.outputFormat = endsWith(opts.output, ".f32") ? "f32" : "csv";
+        }
+        if (opts.nThreads <= 0) {
+            opts.nThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        if (opts.chunkSize <= 0) {
+            throw std::runtime_error("--chunk-size has to be positive");
+        }
+        return opts;
+    }
+
+    // Reads chunks of rows from CSV or raw float32 input
+    class RowReader {
+      public:
+        RowReader(Options& opts) : format_(opts.inputFormat), nFeatures_(opts.nFeatures) {
+            if (opts.input != "-") {
+                file_.open(opts.input.c_str(), std::ios::binary);
+                if (!file_) {
+                    throw std::runtime_error("can't open input file " + opts.input);
+                }
+            }
+            is_ = opts.input == "-" ? &std::cin : &file_;
+
+            if (format_ == "csv") {
+                // The first line determines the number of columns, and is skipped if it is a header
+                if (!std::getline(*is_, pendingLine_)) {
+                    return;
+                }
+                std::vector<std::string> columns = splitColumns(pendingLine_);
+                nFeatures_ = columns.size();
+                char* end = NULL;
+                std::strtof(columns[0].c_str(), &end);
+                if (end == columns[0].c_str()) {
+                    if (opts.features.empty()) {
+                        opts.features = columns;
+                    }
+                    pendingLine_.clear();
+                }
+            } else if (format_ != "f32") {
+                throw std::runtime_error("unknown input format " + format_);
+            } else if (nFeatures_ <= 0) {
+                nFeatures_ = opts.features.size();
+            }
+            if (nFeatures_ <= 0) {
+                throw std::runtime_error("unknown number of features, please use --n-features or --features");
+            }
+        }
+
+        int nFeatures() const { return nFeatures_; }
+
+        // Fills the buffer with up to maxRows rows and returns the number of rows that were read
+        int read(std::vector<float>& buffer, int maxRows) {
+            buffer.resize(static_cast<std::size_t>(maxRows) * nFeatures_);
+            if (format_ == "f32") {
+                is_->read(reinterpret_cast<char*>(buffer.data()), buffer.size() * sizeof(float));
+                const std::size_t rowSize = nFeatures_ * sizeof(float);
+                if (is_->gcount() % rowSize != 0) {
+                    throw std::runtime_error("the f32 input ends with an incomplete row, is --n-features right?");
+                }
+                return is_->gcount() / rowSize;
+            }
+            int nRows = 0;
+            std::string line;
+            while (nRows < maxRows) {
+                if (!pendingLine_.empty()) {
+                    line.swap(pendingLine_);
+                    pendingLine_.clear();
+                } else if (!std::getline(*is_, line)) {
+                    break;
+                }
+                if (line.empty() || line == "\r") {
+                    continue;
+                }
+                const char* pos = line.c_str();
+                float* row = &buffer[static_cast<std::size_t>(nRows) * nFeatures_];
+                for (int j = 0; j < nFeatures_; ++j) {
+                    char* end = NULL;
+                    row[j] = std::strtof(pos, &end);
+                    if (end == pos) {
+                        // empty fields are missing values
+                        row[j] = std::numeric_limits<float>::quiet_NaN();
+                    }
+                    pos = end;
+                    while (isSeparator(*pos)) {
+                        ++pos;
+                    }
+                }
+                ++nRows;
+            }
+            return nRows;
+        }
+
+      private:
+        std::string format_;
+        int nFeatures_;
+        std::ifstream file_;
+        std::istream* is_;
+        std::string pendingLine_;
+    };
+
+    class ScoreWriter {
+      public:
+        ScoreWriter(Options const& opts) : format_(opts.outputFormat) {
+            if (format_ != "csv" && format_ != "f32") {
+                throw std::runtime_error("unknown output format " + format_);
+            }
+            if (opts.output != "-") {
+                file_.open(opts.output.c_str(), std::ios::binary);
+                if (!file_) {
+                    throw std::runtime_error("can't open output file " + opts.output);
+                }
+            }
+            os_ = opts.output == "-" ? &std::cout : &file_;
+        }
+
+        void write(std::vector<float> const& scores, int nRows, int nOut) {
+            if (format_ == "f32") {
+                os_->write(reinterpret_cast<const char*>(scores.data()), nRows * nOut * sizeof(float));
+                return;
+            }
+            std::string text;
+            text.reserve(nRows * nOut * 16);
+            char number[32];
+            for (int i = 0; i < nRows; ++i) {
+                for (int j = 0; j < nOut; ++j) {
+                    const char* fmt = j == 0 ? "%.9g" : ",%.9g";
+                    const int n = std::snprintf(number, sizeof(number), fmt, scores[i * nOut + j]);
+                    text.append(number, n);
+                }
+                text += '\n';
+            }
+            os_->write(text.data(), text.size());
+        }
+
+        void flush() { os_->flush(); }
+
+      private:
+        std::string format_;
+        std::ofstream file_;
+        std::ostream* os_;
+    };
+
+    fastforest::FastForest loadModel(Options& opts, int nFeatures) {
+        if (endsWith(opts.model, ".bin")) {
+            return fastforest::load_bin(opts.model);
+        }
+        if (opts.features.empty()) {
+            for (int i = 0; i < nFeatures; ++i) {
+                std::stringstream ss;
+                ss << "f" << i;
+                opts.features.push_back(ss.str());
+            }
+        }
+#ifdef EXPERIMENTAL_TMVA_SUPPORT
+        if (endsWith(opts.model, ".xml")) {
+            return fastforest::load_tmva_xml(opts.model, opts.features);
+        }
+#endif
+        return fastforest::load_txt(opts.model, opts.features, opts.nClasses);
+    }
+
+    // Throws if the model reads features beyond the input columns, which would read past the end of each row
+    void checkFeatures(fastforest::FastForest const& forest, int nFeatures) {
+        for (std::size_t i = 0; i < forest.cutIndices_.size(); ++i) {
+            if (static_cast<int>(forest.cutIndices_[i]) >= nFeatures) {
+                std::stringstream ss;
+                ss << "the model uses feature " << forest.cutIndices_[i] << ", but the input has only " << nFeatures
+                   << " columns";
+                throw std::runtime_error(ss.str());
+            }
+        }
+    }
+
+    // Scores the rows of a chunk. The rows are split over the threads here, because the library runs its own
+    // evaluation serially if it was compiled without C++11. Only a NumaForest with several replicas, which exist only
+    // in libraries with threading, distributes the rows itself, so the threads run on the nodes of their replicas.
+    void scoreChunk(fastforest::FastForest const& forest,
+                    fastforest::NumaForest const* numaForest,
+                    const float* in,
+                    int nRows,
+                    int nFeatures,
+                    float* out,
+                    int nThreads) {
+        if (numaForest && numaForest->nReplicas() > 1) {
+            numaForest->evaluate(in, nRows, nFeatures, out, nThreads);
+            return;
+        }
+        const int nOut = forest.nOutputs();
+        nThreads = std::max(1, std::min(nThreads, nRows));
+        std::vector<std::thread> threads;
+        int begin = 0;
+        for (int iThread = 0; iThread < nThreads; ++iThread) {
+            const int end = begin + nRows / nThreads + (iThread < nRows % nThreads ? 1 : 0);
+            const float* sliceIn = in + static_cast<std::size_t>(begin) * nFeatures;
+            float* sliceOut = out + static_cast<std::size_t>(begin) * nOut;
+            const int nSliceRows = end - begin;
+            threads.emplace_back([&forest, numaForest, sliceIn, nSliceRows, nFeatures, sliceOut]() {
+                if (numaForest) {
+                    numaForest->evaluate(sliceIn, nSliceRows, nFeatures, sliceOut, 1);
+                } else {
+                    forest.predict(sliceIn, nSliceRows, nFeatures, sliceOut, 1);
+                }
+            });
+            begin = end;
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    int run(int argc, char** argv) {
+        Options opts = parseOptions(argc, argv);
+
+        RowReader reader(opts);
+        const fastforest::FastForest forest = loadModel(opts, reader.nFeatures());
+        const int nFeatures = reader.nFeatures();
+        checkFeatures(forest, nFeatures);
+        const int nOut = forest.nOutputs();
+        const bool softmax = opts.softmax && nOut > 1;
+
+        fastforest::NumaForest* numaForest = opts.numa ? new fastforest::NumaForest(forest) : NULL;
+
+        ScoreWriter writer(opts);
+
+        std::vector<float> inputs[2];
+        std::vector<float> scores[2];
+        int nRows[2] = {0, 0};
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::size_t nRowsTotal = 0;
+
+        nRows[0] = reader.read(inputs[0], opts.chunkSize);
+        std::future<void> writing;
+        for (int current = 0; nRows[current] > 0; current = 1 - current) {
+            const int next = 1 - current;
+            std::future<int> reading =
+                std::async(std::launch::async, [&]() { return reader.read(inputs[next], opts.chunkSize); });
+
+            // the scores buffer of this chunk was last written two chunks ago, which has finished already
+            scores[current].resize(static_cast<std::size_t>(nRows[current]) * nOut);
+            const float* in = inputs[current].data();
+            float* out = scores[current].data();
+            scoreChunk(forest, numaForest, in, nRows[current], nFeatures, out, opts.nThreads);
+            if (softmax) {
+                for (std::size_t i = 0; i < static_cast<std::size_t>(nRows[current]); ++i) {
+                    fastforest::details::softmaxTransformInplace(&scores[current][i * nOut], nOut);
+                }
+            }
+            nRowsTotal += nRows[current];
+
+            if (writing.valid()) {
+                writing.get();
+            }
+            const int nRowsWritten = nRows[current];
+            writing = std::async(std::launch::async, [&writer, &scores, current, nRowsWritten, nOut]() {
+                writer.write(scores[current], nRowsWritten, nOut);
+            });
+
+            nRows[next] = reading.get();
+        }
+        if (writing.valid()) {
+            writing.get();
+        }
+        writer.flush();
+        delete numaForest;
+
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << "fastforest-score: scored " << nRowsTotal << " rows in " << seconds << " s ("
+                  << (seconds > 0 ? nRowsTotal / seconds : 0.0) << " rows/s, " << opts.nThreads << " threads)"
+                  << std::endl;
+        return 0;
+    }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        return run(argc, argv);
+    } catch (std::exception const& e) {
+        std::cerr << "fastforest-score: " << e.what() << "\n\n" << usage;
+        return 1;
+    }
+}